@@ -0,0 +1,35 @@
+project "Chip8-Aot"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++17"
+    staticruntime "off"
+
+    targetdir (outputTargetDir)
+    objdir (outputObjDir)
+
+    debugdir "%{wks.location}/Chip8-Emulator"
+
+    files {
+        "src/**.h",
+        "src/**.cpp",
+        "%{IncludeDir.Chip8Core}/Aot/AotAbi.h"
+    }
+
+    includedirs {
+        "src",
+        "%{IncludeDir.Chip8Core}"
+    }
+
+    filter "system:windows"
+		systemversion "latest"
+		staticruntime "On"
+
+    filter { "configurations:Debug" }
+        symbols "On"
+
+    filter { "configurations:Release" }
+        symbols "On"
+        optimize "On"
+
+    filter { "configurations:Dist" }
+        optimize "On"
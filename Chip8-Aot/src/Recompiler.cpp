@@ -0,0 +1,461 @@
+#include "Recompiler.h"
+
+#include "Aot/AotAbi.h"
+#include "Utils/StringUtils.h"
+
+#include <deque>
+
+namespace
+{
+    constexpr uint32_t RomStart = 0x200;
+
+    uint8_t X(const uint16_t opcode) { return (opcode & 0x0F00) >> 8; }
+    uint8_t Y(const uint16_t opcode) { return (opcode & 0x00F0) >> 4; }
+    uint8_t NN(const uint16_t opcode) { return opcode & 0x00FF; }
+    uint16_t NNN(const uint16_t opcode) { return opcode & 0x0FFF; }
+
+    // Registers an instruction compiled inline reads and writes through its locals. Returns false
+    // if the instruction is left to the interpreter handler.
+    bool GetRegisterUse(const uint16_t opcode, uint16_t& used, uint16_t& written)
+    {
+        const uint16_t x = 1 << X(opcode);
+        const uint16_t y = 1 << Y(opcode);
+        const uint16_t f = 1 << 0xF;
+
+        switch (opcode & 0xF000)
+        {
+        case 0x0000:
+            used = written = 0;
+            return opcode == 0x00EE || (opcode != 0x00E0 && opcode != 0x00FF && opcode != 0x00FE &&
+                opcode != 0x00FB && opcode != 0x00FC && opcode != 0x00FD && (opcode & 0xFFF0) != 0x00C0);
+        case 0x1000:
+        case 0x2000:
+        case 0xA000:
+            used = written = 0;
+            return true;
+        case 0x3000:
+        case 0x4000:
+            used = x;
+            written = 0;
+            return true;
+        case 0x5000:
+        case 0x9000:
+            used = x | y;
+            written = 0;
+            return true;
+        case 0x6000:
+        case 0x7000:
+            used = written = x;
+            return true;
+        case 0x8000:
+            switch (opcode & 0x000F)
+            {
+            case 0x0: case 0x1: case 0x2: case 0x3:
+                used = x | y;
+                written = x;
+                return true;
+            case 0x4: case 0x5: case 0x6: case 0x7: case 0xE:
+                used = x | y | f;
+                written = x | f;
+                return true;
+            default:
+                // Unknown opcodes do nothing
+                used = written = 0;
+                return true;
+            }
+        case 0xF000:
+            switch (opcode & 0x00FF)
+            {
+            case 0x07:
+                used = written = x;
+                return true;
+            case 0x15: case 0x29: case 0x30:
+                used = x;
+                written = 0;
+                return true;
+            case 0x1E:
+                used = x | f;
+                written = f;
+                return true;
+            }
+            break;
+        }
+
+        used = written = 0;
+        return false;
+    }
+
+    void StoreLocals(std::string& out, const uint16_t written)
+    {
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            if (written & (1 << i))
+                out += StringUtils::Format("    s->v[%u] = v%X;\n", i, i);
+        }
+    }
+
+    void LoadLocals(std::string& out, const uint16_t used, const bool declare)
+    {
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            if (used & (1 << i))
+                out += StringUtils::Format("    %sv%X = s->v[%u];\n", declare ? "unsigned char " : "", i, i);
+        }
+    }
+}
+
+Recompiler::Recompiler(const std::vector<uint8_t>& rom) :
+    mRom(rom)
+{}
+
+void Recompiler::Analyse()
+{
+    mBlocks.clear();
+
+    std::deque<uint32_t> pending = { RomStart };
+    while (!std::empty(pending))
+    {
+        const uint32_t startPC = pending.front();
+        pending.pop_front();
+
+        if (!InRom(startPC) || mBlocks.count((uint16_t)startPC) > 0)
+            continue;
+
+        Block block;
+        block.startPC = (uint16_t)startPC;
+
+        uint32_t pc = startPC;
+        while (InRom(pc) && std::size(block.opcodes) < MAX_BLOCK_LENGTH)
+        {
+            const uint16_t opcode = ReadOpcode(pc);
+            block.opcodes.push_back(opcode);
+            pc += 2;
+
+            if (EndsBlock(opcode))
+                break;
+        }
+
+        const uint16_t last = block.opcodes.back();
+        const uint32_t lastPC = pc - 2;
+        if (!EndsBlock(last))
+        {
+            pending.push_back(pc);
+        }
+        else if ((last & 0xF000) == 0x1000)
+        {
+            pending.push_back(NNN(last));
+        }
+        else if ((last & 0xF000) == 0x2000)
+        {
+            pending.push_back(NNN(last));
+            pending.push_back(pc);
+        }
+        else if ((last & 0xF000) == 0xB000)
+        {
+            // Jump tables are usually a run of 1NNN instructions indexed by V0
+            for (uint32_t offset = 0; offset <= 0xFF; offset += 2)
+                pending.push_back(NNN(last) + offset);
+        }
+        else if ((last & 0xF0FF) == 0xF00A)
+        {
+            pending.push_back(lastPC);
+            pending.push_back(pc);
+        }
+        else if ((last & 0xF000) == 0xD000)
+        {
+            // Draws only end a block so the frame can be shown
+            pending.push_back(pc);
+        }
+        else if (last != 0x00EE && last != 0x00FD)
+        {
+            // Skips
+            pending.push_back(pc);
+            pending.push_back(pc + 2);
+        }
+
+        mBlocks[block.startPC] = std::move(block);
+    }
+}
+
+std::string Recompiler::Generate(const std::string& romName) const
+{
+    std::string out;
+    out += "// Recompiled from " + romName + " by Chip8-Aot. Do not edit.\n\n";
+
+    out += "#ifdef _WIN32\n";
+    out += "#   define CHIP8_AOT_EXPORT __declspec(dllexport)\n";
+    out += "#else\n";
+    out += "#   define CHIP8_AOT_EXPORT __attribute__((visibility(\"default\")))\n";
+    out += "#endif\n\n";
+
+    out += "extern \"C\"\n{\n";
+    out += CHIP8_AOT_ABI_SOURCE;
+    out += "\n}\n\n";
+
+    out += "namespace\n{\n";
+
+    for (const auto& [startPC, block] : mBlocks)
+        GenerateBlock(out, block);
+
+    // Every instruction is an entry, unless another block starts there
+    std::map<uint16_t, std::pair<const Block*, uint32_t>> entries;
+    for (const auto& [startPC, block] : mBlocks)
+    {
+        for (uint32_t i = 0; i < std::size(block.opcodes); ++i)
+        {
+            const uint16_t pc = (uint16_t)(startPC + i * 2);
+            if (i == 0 || mBlocks.count(pc) == 0)
+                entries.emplace(pc, std::make_pair(&block, i));
+        }
+    }
+
+    out += "const Chip8AotBlock Blocks[] =\n{\n";
+    for (const auto& [pc, entry] : entries)
+    {
+        const auto& [block, index] = entry;
+        const uint32_t length = (uint32_t)std::size(block->opcodes) - index;
+        out += StringUtils::Format("    { 0x%04X, %u, %u, &Block_%04X },\n", pc, length, index, block->startPC);
+    }
+    out += "};\n\n";
+
+    out += "const Chip8AotModuleInfo ModuleInfo =\n{\n";
+    out += StringUtils::Format("    %u,\n", CHIP8_AOT_ABI_VERSION);
+    out += StringUtils::Format("    %u,\n", (uint32_t)std::size(mRom));
+    out += StringUtils::Format("    0x%016llXull,\n", (unsigned long long)HashAotRom(std::data(mRom), std::size(mRom)));
+    out += "    sizeof(Blocks) / sizeof(Blocks[0]),\n";
+    out += "    Blocks\n";
+    out += "};\n";
+    out += "}\n\n";
+
+    out += "extern \"C\" CHIP8_AOT_EXPORT const Chip8AotModuleInfo* Chip8AotGetModuleInfo(void)\n";
+    out += "{\n";
+    out += "    return &ModuleInfo;\n";
+    out += "}\n";
+
+    return out;
+}
+
+bool Recompiler::InRom(const uint32_t pc) const
+{
+    return pc >= RomStart && pc + 1 < RomStart + std::size(mRom);
+}
+
+uint16_t Recompiler::ReadOpcode(const uint32_t pc) const
+{
+    return (mRom[pc - RomStart] << 8) | mRom[pc + 1 - RomStart];
+}
+
+// Mirrors Chip8::EndsBlock, decoding the opcode the same way the instruction table does
+bool Recompiler::EndsBlock(const uint16_t opcode)
+{
+    switch (opcode & 0xF000)
+    {
+    case 0x0000: return opcode == 0x00EE || opcode == 0x00FD;
+    case 0x1000:
+    case 0x2000:
+    case 0x3000:
+    case 0x4000:
+    case 0x5000:
+    case 0x9000:
+    case 0xB000:
+    case 0xD000: return true;
+    case 0xE000: return NN(opcode) == 0x9E || NN(opcode) == 0xA1;
+    case 0xF000: return NN(opcode) == 0x0A;
+    }
+
+    return false;
+}
+
+void Recompiler::GenerateBlock(std::string& out, const Block& block) const
+{
+    BlockContext ctx;
+    for (const uint16_t opcode : block.opcodes)
+    {
+        uint16_t used = 0;
+        uint16_t written = 0;
+        GetRegisterUse(opcode, used, written);
+        ctx.used |= used | written;
+        ctx.written |= written;
+    }
+
+    const uint32_t length = (uint32_t)std::size(block.opcodes);
+    out += StringUtils::Format("unsigned int Block_%04X(const Chip8AotState* s, const unsigned int entry)\n{\n", block.startPC);
+    LoadLocals(out, ctx.used, true);
+    out += "    switch (entry)\n    {\n";
+
+    uint16_t pc = block.startPC;
+    for (uint32_t i = 0; i < length; ++i, pc += 2)
+    {
+        const uint16_t opcode = block.opcodes[i];
+        const bool isLast = (i + 1 == length);
+        out += StringUtils::Format("    case %u: // 0x%04X: 0x%04X\n", i, pc, opcode);
+
+        uint16_t used = 0;
+        uint16_t written = 0;
+        if (GetRegisterUse(opcode, used, written))
+            GenerateInstruction(out, ctx, opcode, pc, i + 1, isLast);
+        else
+            GenerateHelperCall(out, ctx, opcode, pc, i + 1, isLast);
+    }
+
+    out += "    }\n";
+    out += "    return 0;\n}\n\n";
+}
+
+void Recompiler::GenerateInstruction(std::string& out, BlockContext& ctx, const uint16_t opcode, const uint16_t pc, const uint32_t executed, const bool isLast)
+{
+    const uint8_t x = X(opcode);
+    const uint8_t y = Y(opcode);
+    const uint8_t nn = NN(opcode);
+    const uint16_t nnn = NNN(opcode);
+
+    // Statements follow the order of the interpreter handlers, so VF aliasing X or Y behaves the same
+    switch (opcode & 0xF000)
+    {
+    case 0x0000:
+        if (opcode == 0x00EE)
+        {
+            out += "    *s->sp = (unsigned short)((*s->sp - 1) & 0xF);\n";
+            out += "    *s->pc = s->stack[*s->sp];\n";
+            GenerateExit(out, ctx, opcode, executed);
+            return;
+        }
+        break;
+
+    case 0x1000:
+        out += StringUtils::Format("    *s->pc = 0x%04X;\n", nnn);
+        GenerateExit(out, ctx, opcode, executed);
+        return;
+
+    case 0x2000:
+        out += StringUtils::Format("    s->stack[*s->sp & 0xF] = 0x%04X;\n", (uint16_t)(pc + 2));
+        out += "    *s->sp = (unsigned short)((*s->sp + 1) & 0xF);\n";
+        out += StringUtils::Format("    *s->pc = 0x%04X;\n", nnn);
+        GenerateExit(out, ctx, opcode, executed);
+        return;
+
+    case 0x3000:
+    case 0x4000:
+    case 0x5000:
+    case 0x9000:
+    {
+        std::string condition;
+        switch (opcode & 0xF000)
+        {
+        case 0x3000: condition = StringUtils::Format("v%X == 0x%02X", x, nn); break;
+        case 0x4000: condition = StringUtils::Format("v%X != 0x%02X", x, nn); break;
+        case 0x5000: condition = StringUtils::Format("v%X == v%X", x, y); break;
+        case 0x9000: condition = StringUtils::Format("v%X != v%X", x, y); break;
+        }
+
+        out += StringUtils::Format("    *s->pc = (%s) ? 0x%04X : 0x%04X;\n", condition.c_str(), (uint16_t)(pc + 4), (uint16_t)(pc + 2));
+        GenerateExit(out, ctx, opcode, executed);
+        return;
+    }
+
+    case 0x6000:
+        out += StringUtils::Format("    v%X = 0x%02X;\n", x, nn);
+        break;
+
+    case 0x7000:
+        out += StringUtils::Format("    v%X = (unsigned char)(v%X + 0x%02X);\n", x, x, nn);
+        break;
+
+    case 0x8000:
+        switch (opcode & 0x000F)
+        {
+        case 0x0: out += StringUtils::Format("    v%X = v%X;\n", x, y); break;
+        case 0x1: out += StringUtils::Format("    v%X |= v%X;\n", x, y); break;
+        case 0x2: out += StringUtils::Format("    v%X &= v%X;\n", x, y); break;
+        case 0x3: out += StringUtils::Format("    v%X ^= v%X;\n", x, y); break;
+        case 0x4:
+            out += StringUtils::Format("    vF = (v%X + v%X) > 0xFF;\n", x, y);
+            out += StringUtils::Format("    v%X = (unsigned char)(v%X + v%X);\n", x, x, y);
+            break;
+        case 0x5:
+            out += StringUtils::Format("    vF = v%X > v%X;\n", x, y);
+            out += StringUtils::Format("    v%X = (unsigned char)(v%X - v%X);\n", x, x, y);
+            break;
+        case 0x6:
+            out += StringUtils::Format("    if (*s->useVYForShiftQuirk) v%X = v%X;\n", x, y);
+            out += StringUtils::Format("    vF = v%X & 0x1;\n", x);
+            out += StringUtils::Format("    v%X >>= 1;\n", x);
+            break;
+        case 0x7:
+            out += StringUtils::Format("    vF = v%X > v%X;\n", y, x);
+            out += StringUtils::Format("    v%X = (unsigned char)(v%X - v%X);\n", x, y, x);
+            break;
+        case 0xE:
+            out += StringUtils::Format("    if (*s->useVYForShiftQuirk) v%X = v%X;\n", x, y);
+            out += StringUtils::Format("    vF = v%X >> 7;\n", x);
+            out += StringUtils::Format("    v%X = (unsigned char)(v%X << 1);\n", x, x);
+            break;
+        }
+        break;
+
+    case 0xA000:
+        out += StringUtils::Format("    *s->indexReg = 0x%04X;\n", nnn);
+        break;
+
+    case 0xF000:
+        switch (nn)
+        {
+        case 0x07:
+            out += StringUtils::Format("    v%X = *s->delayTimer;\n", x);
+            break;
+        case 0x15:
+            out += StringUtils::Format("    *s->delayTimer = v%X;\n", x);
+            break;
+        case 0x1E:
+            out += StringUtils::Format("    vF = (*s->indexReg + v%X) > 0x0FFF;\n", x);
+            out += StringUtils::Format("    *s->indexReg = (unsigned short)(*s->indexReg + v%X);\n", x);
+            break;
+        case 0x29:
+            out += StringUtils::Format("    *s->indexReg = (unsigned short)(v%X * 5);\n", x);
+            break;
+        case 0x30:
+            out += StringUtils::Format("    *s->indexReg = (unsigned short)(v%X * 10 + 80);\n", x);
+            break;
+        }
+        break;
+    }
+
+    // Unknown opcodes also end up here, and do nothing
+    if (isLast)
+    {
+        out += StringUtils::Format("    *s->pc = 0x%04X;\n", (uint16_t)(pc + 2));
+        GenerateExit(out, ctx, opcode, executed);
+    }
+}
+
+// Runs an instruction through the interpreter handler with the emulator state up to date
+void Recompiler::GenerateHelperCall(std::string& out, BlockContext& ctx, const uint16_t opcode, const uint16_t pc, const uint32_t executed, const bool isLast)
+{
+    StoreLocals(out, ctx.written);
+    out += StringUtils::Format("    *s->pc = 0x%04X;\n", (uint16_t)(pc + 2));
+    out += StringUtils::Format("    s->execute(s->chip8, 0x%04X);\n", opcode);
+
+    if (isLast)
+    {
+        out += StringUtils::Format("    return %u - entry;\n", executed);
+        return;
+    }
+
+    LoadLocals(out, ctx.used, false);
+
+    // Stop right away if the store overwrote recompiled code, possibly this block
+    const uint16_t kind = opcode & 0xF0FF;
+    if (kind == 0xF033 || kind == 0xF055)
+    {
+        out += "    if (*s->codeModified)\n";
+        out += StringUtils::Format("        return %u - entry;\n", executed);
+    }
+}
+
+// Leaves the emulator state exactly as the interpreter would have after the block's last instruction
+void Recompiler::GenerateExit(std::string& out, BlockContext& ctx, const uint16_t opcode, const uint32_t executed)
+{
+    StoreLocals(out, ctx.written);
+    out += StringUtils::Format("    *s->opcode = 0x%04X;\n", opcode);
+    out += StringUtils::Format("    return %u - entry;\n", executed);
+}
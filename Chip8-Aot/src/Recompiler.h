@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/*
+ * Statically recompiles a rom into C++ with one function per reachable basic block.
+ *
+ * Blocks are found by following every static path from 0x200: fall through, jumps, calls and
+ * the return address after them, both sides of skips, and every even offset of a BNNN table.
+ * Whatever can't be reached this way, like code built at runtime, runs on the interpreter.
+ */
+class Recompiler
+{
+public:
+    // A block only runs when the frame budget covers all of it and a frame runs 9 cycles at the
+    // default speed, so longer runs of code are split into pieces
+    static constexpr uint32_t MAX_BLOCK_LENGTH = 8;
+
+public:
+    Recompiler(const std::vector<uint8_t>& rom);
+
+    void Analyse();
+    std::string Generate(const std::string& romName) const;
+
+    size_t GetNumBlocks() const { return std::size(mBlocks); }
+
+private:
+    struct Block
+    {
+        uint16_t startPC = 0;
+        std::vector<uint16_t> opcodes;
+    };
+
+    struct BlockContext
+    {
+        uint16_t used = 0;    // V registers kept in locals
+        uint16_t written = 0; // Locals to store back before leaving the block or calling a handler
+    };
+
+private:
+    bool InRom(const uint32_t pc) const;
+    uint16_t ReadOpcode(const uint32_t pc) const;
+
+    static bool EndsBlock(const uint16_t opcode);
+
+    void GenerateBlock(std::string& out, const Block& block) const;
+    static void GenerateInstruction(std::string& out, BlockContext& ctx, const uint16_t opcode, const uint16_t pc, const uint32_t executed, const bool isLast);
+    static void GenerateHelperCall(std::string& out, BlockContext& ctx, const uint16_t opcode, const uint16_t pc, const uint32_t executed, const bool isLast);
+    static void GenerateExit(std::string& out, BlockContext& ctx, const uint16_t opcode, const uint32_t executed);
+
+private:
+    std::vector<uint8_t> mRom;
+    std::map<uint16_t, Block> mBlocks;
+};
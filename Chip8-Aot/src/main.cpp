@@ -0,0 +1,102 @@
+
+#include "Recompiler.h"
+
+#include "Aot/AotAbi.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Recompiles a rom ahead of time into a shared library the emulator loads when the rom is
+// opened and the AOT backend is selected. The library is written next to the rom by default,
+// which is where the emulator looks for it.
+//
+// Usage: Chip8-Aot <rom> [output library] [--source-only]
+//
+// The generated source is kept next to the library. It's built with cl on Windows, which needs
+// a developer command prompt, and with $CXX (or c++) everywhere else.
+
+namespace
+{
+    bool ReadRom(const std::filesystem::path& path, std::vector<uint8_t>& rom)
+    {
+        std::ifstream file(path, std::ios_base::in | std::ios_base::binary);
+        if (!file)
+            return false;
+
+        rom.resize((size_t)std::filesystem::file_size(path));
+        file.read((char*)std::data(rom), std::size(rom));
+        return (bool)file;
+    }
+
+    std::string GetCompileCommand(const std::filesystem::path& source, const std::filesystem::path& library)
+    {
+#ifdef _WIN32
+        return "cl /nologo /O2 /LD \"" + source.string() + "\" /Fe\"" + library.string() + "\" /link /NOIMPLIB /NOEXP";
+#else
+        const char* cxx = getenv("CXX");
+        return std::string(cxx ? cxx : "c++") + " -O2 -shared -fPIC -o \"" + library.string() + "\" \"" + source.string() + "\"";
+#endif
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> args;
+    bool sourceOnly = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--source-only")
+            sourceOnly = true;
+        else
+            args.push_back(argv[i]);
+    }
+
+    if (std::empty(args))
+    {
+        fprintf(stderr, "Usage: Chip8-Aot <rom> [output library] [--source-only]\n");
+        return -1;
+    }
+
+    const std::filesystem::path romPath = args[0];
+    const std::filesystem::path library = (std::size(args) > 1) ? std::filesystem::path(args[1]) : GetAotLibraryPath(romPath);
+
+    std::vector<uint8_t> rom;
+    if (!ReadRom(romPath, rom) || std::empty(rom))
+    {
+        fprintf(stderr, "Unable to read rom %s\n", romPath.string().c_str());
+        return -1;
+    }
+
+    Recompiler recompiler(rom);
+    recompiler.Analyse();
+
+    std::filesystem::path source = library;
+    source.replace_extension(".cpp");
+    {
+        std::ofstream file(source);
+        file << recompiler.Generate(romPath.filename().string());
+        if (!file)
+        {
+            fprintf(stderr, "Unable to write %s\n", source.string().c_str());
+            return -1;
+        }
+    }
+
+    printf("Recompiled %zu blocks from %s into %s\n", recompiler.GetNumBlocks(), romPath.string().c_str(), source.string().c_str());
+    if (sourceOnly)
+        return 0;
+
+    const std::string command = GetCompileCommand(source, library);
+    printf("%s\n", command.c_str());
+    if (system(command.c_str()) != 0)
+    {
+        fprintf(stderr, "Failed to compile %s\n", source.string().c_str());
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,684 @@
+
+#include "Chip8.h"
+#include "Log.h"
+#include "Movie.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+// Compares the dispatch backends by running every bundled rom headless for the same
+// number of cycles with the same random seed, under every combination of quirks. Each
+// backend also runs a synthetic loop per opcode class to show what each kind of
+// instruction costs. With --pairs it instead reports which instructions run back to
+// back the most, which is what the block cache's fused instructions are picked from.
+//
+// Idle loops are run rather than skipped, and the cycles a game spends parked on FX0A aren't
+// counted as instructions, so the times are what dispatch costs. The idle column is the share of
+// cycles the game spent parked, and roms parked for most of the run are marked and left out of
+// the geomeans.
+//
+// --json writes the results to a file, which can later be passed to --baseline. A run
+// against a baseline fails when the geomean ns/instruction of any backend and quirk
+// profile got slower by more than the threshold percentage.
+//
+// --movie plays a movie recorded with Chip8-Cli or the emulator back on every backend instead,
+// timing real gameplay rather than a rom left to run on its own. Its rom is found in the rom
+// directory by hash. Each backend is checked against the recorded state hashes once before it's
+// timed, and the run fails if any of them diverges.
+//
+// Usage: Chip8-Bench [rom directory] [cycles] [--pairs] [--repeat N] [--json file]
+//                    [--baseline file] [--threshold percent] [--movie file]
+
+namespace
+{
+    constexpr uint64_t RandomSeed = 1;
+    constexpr uint64_t DefaultCycles = 500000;
+    // Timing runs are repeated and the fastest kept, which filters out most scheduling noise
+    constexpr uint32_t DefaultRepeats = 3;
+    constexpr double DefaultThreshold = 10.0;
+    // A rom parked on FX0A for more than this share of its cycles runs too few instructions for
+    // its time to say anything about dispatch, so it's left out of the geomeans
+    constexpr double MaxIdleShare = 0.5;
+    // Instructions in each opcode class loop before it jumps back
+    constexpr uint32_t OpcodeClassLoopLength = 60;
+
+    struct BackendInfo
+    {
+        Chip8::Backend backend;
+        const char* name;
+    };
+
+    constexpr BackendInfo Backends[] = {
+        { Chip8::Backend::eSwitch, "switch" },
+        { Chip8::Backend::eTable, "table" },
+        { Chip8::Backend::eBlockCache, "block" },
+        { Chip8::Backend::eJit, "jit" },
+        { Chip8::Backend::eAot, "aot" }
+    };
+
+    void PrintUsage()
+    {
+        fprintf(stderr, "Usage: Chip8-Bench [rom directory] [cycles] [--pairs] [--repeat N] [--json file]\n"
+                        "                   [--baseline file] [--threshold percent] [--movie file]\n");
+    }
+
+    // std::stoull and std::stod stop at the first character they can't read and take a minus
+    // sign, which would let "10k" through as 10 and "-1" as a huge count, so those throw too
+    uint64_t ParseCount(const std::string& text)
+    {
+        size_t end = 0;
+        const uint64_t value = std::stoull(text, &end);
+        if (end != std::size(text) || text[0] == '-')
+            throw std::invalid_argument(text);
+        return value;
+    }
+
+    double ParsePercent(const std::string& text)
+    {
+        size_t end = 0;
+        const double value = std::stod(text, &end);
+        if (end != std::size(text) || !(value >= 0.0))
+            throw std::invalid_argument(text);
+        return value;
+    }
+
+    // Bit 0 is the VY shift quirk, bit 1 the BXNN quirk and bit 2 the index increment quirk
+    constexpr uint32_t NumQuirkProfiles = 8;
+
+    // The body of each opcode class loop, repeated until the loop is full. Every opcode
+    // falls through to the next one, with V1 set to 1 and every other register 0 going in.
+    struct OpcodeClass
+    {
+        const char* name;
+        std::vector<uint16_t> body;
+    };
+
+    const std::vector<OpcodeClass> OpcodeClasses = {
+        { "00E0", { 0x00E0 } },
+        { "1NNN", {} }, // Jumps to the next instruction, generated from the address
+        { "3XNN", { 0x3001 } },
+        { "4XNN", { 0x4000 } },
+        { "5XY0", { 0x5010 } },
+        { "6XNN", { 0x6005 } },
+        { "7XNN", { 0x7001 } },
+        { "8XYN", { 0x8014, 0x8015, 0x8012, 0x8016 } },
+        { "9XY0", { 0x9000 } },
+        { "ANNN", { 0xA300 } },
+        { "CXNN", { 0xC0FF } },
+        { "DXYN", { 0xD015 } },
+        { "EXNN", { 0xE09E } },
+        { "FXNN", { 0xF01E, 0xF029, 0xF015, 0xF007 } }
+    };
+
+    struct RunResult
+    {
+        // Instructions run, without the idle cycles
+        uint64_t cycles = 0;
+        uint64_t idleCycles = 0;
+        uint64_t frames = 0;
+        double seconds = 0.0;
+
+        double GetNsPerInstruction() const { return (cycles > 0) ? seconds * 1e9 / cycles : 0.0; }
+        double GetIdleShare() const { return (cycles + idleCycles > 0) ? (double)idleCycles / (cycles + idleCycles) : 0.0; }
+        double GetInstructionsPerSecond() const { return (seconds > 0.0) ? cycles / seconds : 0.0; }
+        double GetFramesPerSecond() const { return (seconds > 0.0) ? frames / seconds : 0.0; }
+    };
+
+    struct RomResult
+    {
+        std::string rom;
+        size_t backend = 0;
+        uint32_t quirks = 0;
+        RunResult run;
+    };
+
+    struct Summary
+    {
+        size_t backend = 0;
+        uint32_t quirks = 0;
+        double geomeanNs = 0.0;
+    };
+
+    std::string GetQuirksName(const uint32_t quirks)
+    {
+        constexpr const char* QuirkNames[] = { "vy", "bxnn", "index" };
+
+        std::string name;
+        for (uint32_t i = 0; i < std::size(QuirkNames); ++i)
+        {
+            if (quirks & (1 << i))
+                name += (std::empty(name) ? "" : "+") + std::string(QuirkNames[i]);
+        }
+        return std::empty(name) ? "none" : name;
+    }
+
+    void ApplyQuirks(Chip8& chip8, const uint32_t quirks)
+    {
+        chip8.SetUseVYForShiftQuirk(quirks & 1);
+        chip8.SetUseBXNNQuirk(quirks & 2);
+        chip8.SetUseIndexIncrementAfterStoreLoadQuirk(quirks & 4);
+    }
+
+    // Adds a frame's cycles to the result, with the idle ones kept apart
+    void AddFrame(RunResult& result, const Chip8& chip8, const uint64_t totalBefore, const uint64_t idleBefore)
+    {
+        const uint64_t idle = chip8.GetIdleCycles() - idleBefore;
+        result.cycles += chip8.GetTotalCycles() - totalBefore - idle;
+        result.idleCycles += idle;
+        ++result.frames;
+    }
+
+    // Runs the rom for the number of cycles a frame at a time, the way a frontend would
+    RunResult RunOnce(const std::filesystem::path& rom, const Chip8::Backend backend, const uint32_t quirks, const uint64_t cycles)
+    {
+        Chip8 chip8;
+        chip8.SetBackend(backend);
+        chip8.SetIdleSkipping(false);
+        ApplyQuirks(chip8, quirks);
+        chip8.SetRandomSeed(RandomSeed);
+        chip8.LoadGame(rom);
+
+        const uint32_t frameCycles = std::max(chip8.GetInstructionsPerSecond() / chip8.GetFrameRate(), 1u);
+
+        RunResult result;
+        const auto start = std::chrono::steady_clock::now();
+        // Parked cycles count towards the run, or a game waiting for a key would never finish it
+        while (chip8.GetTotalCycles() < cycles && !std::empty(chip8.GetGameFile()))
+        {
+            const uint64_t before = chip8.GetTotalCycles();
+            const uint64_t idleBefore = chip8.GetIdleCycles();
+            chip8.Step((uint32_t)std::min<uint64_t>(frameCycles, cycles - before));
+            // A game exit resets the count, so stop counting there
+            if (std::empty(chip8.GetGameFile()))
+                break;
+
+            AddFrame(result, chip8, before, idleBefore);
+        }
+        const auto end = std::chrono::steady_clock::now();
+
+        result.seconds = std::chrono::duration<double>(end - start).count();
+        return result;
+    }
+
+    RunResult RunRom(const std::filesystem::path& rom, const Chip8::Backend backend, const uint32_t quirks, const uint64_t cycles, const uint32_t repeats)
+    {
+        RunResult best;
+        for (uint32_t i = 0; i < repeats; ++i)
+        {
+            const RunResult result = RunOnce(rom, backend, quirks, cycles);
+            if (i == 0 || result.seconds < best.seconds)
+                best = result;
+        }
+        return best;
+    }
+
+    // Plays the whole movie back a frame at a time, the way the emulator does while playing one
+    RunResult ReplayOnce(const std::filesystem::path& rom, Movie& movie, const Chip8::Backend backend,
+        const bool checkHashes, uint64_t& divergedFrame)
+    {
+        Chip8 chip8;
+        chip8.SetBackend(backend);
+        chip8.SetIdleSkipping(false);
+        chip8.LoadGame(rom);
+        movie.StartPlayback(chip8, checkHashes);
+
+        RunResult result;
+        const auto start = std::chrono::steady_clock::now();
+        for (;;)
+        {
+            const uint64_t before = chip8.GetTotalCycles();
+            const uint64_t idleBefore = chip8.GetIdleCycles();
+            if (!movie.RunFrame(chip8, 0) || std::empty(chip8.GetGameFile()))
+                break;
+
+            AddFrame(result, chip8, before, idleBefore);
+        }
+        const auto end = std::chrono::steady_clock::now();
+
+        result.seconds = std::chrono::duration<double>(end - start).count();
+        divergedFrame = movie.GetDivergedFrame();
+        return result;
+    }
+
+    // Returns whether every backend played the movie back without diverging
+    bool BenchMovie(const std::filesystem::path& moviePath, const std::vector<std::filesystem::path>& roms, const uint32_t repeats)
+    {
+        Movie movie;
+        if (!movie.Load(moviePath))
+        {
+            fprintf(stderr, "Can't read movie %s\n", moviePath.string().c_str());
+            return false;
+        }
+
+        const auto rom = std::find_if(std::begin(roms), std::end(roms), [&movie](const std::filesystem::path& path) {
+            Chip8 chip8;
+            chip8.LoadGame(path);
+            return chip8.GetRomHash() == movie.GetRomHash();
+        });
+        if (rom == std::end(roms))
+        {
+            fprintf(stderr, "None of the roms is the one %s was made with\n", moviePath.string().c_str());
+            return false;
+        }
+
+        printf("%s on %s, %llu frames\n", moviePath.filename().string().c_str(), rom->filename().string().c_str(),
+            (unsigned long long)movie.GetNumFrames());
+        printf("%-12s%12s%12s%12s%8s  %s\n", "backend", "ns/instr", "Minstr/s", "frames/s", "idle", "check");
+
+        bool passed = true;
+        for (const auto& info : Backends)
+        {
+            uint64_t divergedFrame = Movie::NO_FRAME;
+            ReplayOnce(*rom, movie, info.backend, true, divergedFrame);
+
+            RunResult best;
+            for (uint32_t i = 0; i < repeats; ++i)
+            {
+                uint64_t unused = Movie::NO_FRAME;
+                const RunResult result = ReplayOnce(*rom, movie, info.backend, false, unused);
+                if (i == 0 || result.seconds < best.seconds)
+                    best = result;
+            }
+
+            std::string check = movie.HasHashes() ? "matched" : "no hashes";
+            if (divergedFrame != Movie::NO_FRAME)
+            {
+                check = "DIVERGED at frame " + std::to_string(divergedFrame);
+                passed = false;
+            }
+            printf("%-12s%12.2f%12.1f%12.0f%7.1f%%  %s\n", info.name, best.GetNsPerInstruction(), best.GetInstructionsPerSecond() / 1e6,
+                best.GetFramesPerSecond(), best.GetIdleShare() * 100.0, check.c_str());
+        }
+        return passed;
+    }
+
+    std::filesystem::path WriteOpcodeClassRom(const OpcodeClass& opcodeClass)
+    {
+        constexpr uint16_t LoopStart = 0x202;
+
+        std::vector<uint16_t> opcodes = { 0x6101 };
+        for (uint32_t i = 0; i < OpcodeClassLoopLength; ++i)
+        {
+            const uint16_t pc = (uint16_t)(LoopStart + i * 2);
+            if (std::empty(opcodeClass.body))
+                opcodes.push_back(0x1000 | (pc + 2));
+            else
+                opcodes.push_back(opcodeClass.body[i % std::size(opcodeClass.body)]);
+        }
+        opcodes.push_back(0x1000 | LoopStart);
+
+        const auto path = std::filesystem::temp_directory_path() / ("Chip8-Bench-" + std::string(opcodeClass.name) + ".ch8");
+        std::ofstream f(path, std::ios_base::out | std::ios_base::binary);
+        for (const uint16_t opcode : opcodes)
+        {
+            f.put((char)(opcode >> 8));
+            f.put((char)(opcode & 0xFF));
+        }
+        return path;
+    }
+
+    std::string EscapeJson(const std::string& text)
+    {
+        std::string escaped;
+        for (const char c : text)
+        {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    // Every result is written as an object on a line of its own, so baselines can be read back
+    // a line at a time without a JSON library
+    void WriteJson(const std::filesystem::path& filepath, const uint64_t cycles, const std::vector<RomResult>& results,
+        const std::vector<std::vector<double>>& classCosts, const std::vector<Summary>& summaries)
+    {
+        std::ofstream f(filepath);
+        f << "{\n";
+        f << "  \"cycles\": " << cycles << ",\n";
+
+        f << "  \"results\": [\n";
+        for (size_t i = 0; i < std::size(results); ++i)
+        {
+            const RomResult& result = results[i];
+            f << "    { \"rom\": \"" << EscapeJson(result.rom) << "\", \"backend\": \"" << Backends[result.backend].name
+              << "\", \"quirks\": \"" << GetQuirksName(result.quirks) << "\", \"cycles\": " << result.run.cycles
+              << ", \"idleCycles\": " << result.run.idleCycles
+              << ", \"instructionsPerSecond\": " << result.run.GetInstructionsPerSecond()
+              << ", \"framesPerSecond\": " << result.run.GetFramesPerSecond()
+              << ", \"nsPerInstruction\": " << result.run.GetNsPerInstruction() << " }"
+              << ((i + 1 < std::size(results)) ? ",\n" : "\n");
+        }
+        f << "  ],\n";
+
+        f << "  \"opcodeClasses\": [\n";
+        for (size_t backend = 0; backend < std::size(classCosts); ++backend)
+        {
+            for (size_t i = 0; i < std::size(OpcodeClasses); ++i)
+            {
+                const bool last = backend + 1 == std::size(classCosts) && i + 1 == std::size(OpcodeClasses);
+                f << "    { \"backend\": \"" << Backends[backend].name << "\", \"class\": \"" << OpcodeClasses[i].name
+                  << "\", \"nsPerInstruction\": " << classCosts[backend][i] << " }" << (last ? "\n" : ",\n");
+            }
+        }
+        f << "  ],\n";
+
+        f << "  \"summary\": [\n";
+        for (size_t i = 0; i < std::size(summaries); ++i)
+        {
+            const Summary& summary = summaries[i];
+            f << "    { \"backend\": \"" << Backends[summary.backend].name << "\", \"quirks\": \"" << GetQuirksName(summary.quirks)
+              << "\", \"geomeanNsPerInstruction\": " << summary.geomeanNs << " }"
+              << ((i + 1 < std::size(summaries)) ? ",\n" : "\n");
+        }
+        f << "  ]\n";
+        f << "}\n";
+    }
+
+    // Finds "key": value on a line written by WriteJson, without the quotes of string values
+    std::string FindJsonValue(const std::string& line, const std::string& key)
+    {
+        const std::string pattern = "\"" + key + "\": ";
+        size_t start = line.find(pattern);
+        if (start == std::string::npos)
+            return "";
+
+        start += std::size(pattern);
+        if (line[start] == '"')
+            return line.substr(start + 1, line.find('"', start + 1) - start - 1);
+
+        return line.substr(start, line.find_first_of(",}", start) - start);
+    }
+
+    // Maps "backend quirks" to the geomean ns/instruction of a baseline written by --json
+    std::map<std::string, double> ReadBaseline(const std::filesystem::path& filepath)
+    {
+        std::map<std::string, double> baseline;
+        std::ifstream f(filepath);
+        std::string line;
+        while (std::getline(f, line))
+        {
+            const std::string ns = FindJsonValue(line, "geomeanNsPerInstruction");
+            if (!std::empty(ns))
+                baseline[FindJsonValue(line, "backend") + " " + FindJsonValue(line, "quirks")] = std::stod(ns);
+        }
+        return baseline;
+    }
+
+    // Returns whether every backend and quirk profile is within the threshold of the baseline
+    bool CompareToBaseline(const std::map<std::string, double>& baseline, const std::vector<Summary>& summaries, const double threshold)
+    {
+        bool passed = true;
+        printf("\n%-24s%12s%12s%10s\n", "vs baseline (ns/instr)", "baseline", "now", "change");
+        for (const Summary& summary : summaries)
+        {
+            const std::string key = std::string(Backends[summary.backend].name) + " " + GetQuirksName(summary.quirks);
+            const auto it = baseline.find(key);
+            if (it == std::end(baseline) || it->second <= 0.0)
+                continue;
+
+            const double change = 100.0 * (summary.geomeanNs - it->second) / it->second;
+            const bool regressed = change > threshold;
+            passed &= !regressed;
+            printf("%-24s%12.2f%12.2f%+9.1f%%%s\n", key.c_str(), it->second, summary.geomeanNs, change, regressed ? "  REGRESSED" : "");
+        }
+        return passed;
+    }
+
+    // Counts consecutive pairs of executed instructions across every rom, keyed by the
+    // opcode pattern each handler starts its log line with
+    void ReportOpcodePairs(const std::vector<std::filesystem::path>& roms, const uint64_t cycles)
+    {
+        constexpr size_t NumPairsShown = 32;
+
+        std::map<std::pair<std::string, std::string>, uint64_t> pairCounts;
+        uint64_t numPairs = 0;
+        for (const auto& rom : roms)
+        {
+            std::string previous;
+            Chip8 chip8;
+            chip8.SetBackend(Chip8::Backend::eBlockCache);
+            chip8.SetOpcodeLogFunc([&](const std::string& line) {
+                std::string pattern = line.substr(0, line.find(':'));
+                if (!std::empty(previous))
+                {
+                    ++pairCounts[{ previous, pattern }];
+                    ++numPairs;
+                }
+                previous = std::move(pattern);
+            });
+            chip8.SetRandomSeed(RandomSeed);
+            chip8.LoadGame(rom);
+
+            const uint32_t frameCycles = std::max(chip8.GetInstructionsPerSecond() / chip8.GetFrameRate(), 1u);
+            for (uint64_t i = 0; i < cycles && !std::empty(chip8.GetGameFile()); i += frameCycles)
+                chip8.Step(frameCycles);
+        }
+
+        std::vector<std::pair<uint64_t, std::pair<std::string, std::string>>> sorted;
+        for (const auto& [pair, count] : pairCounts)
+            sorted.push_back({ count, pair });
+        std::sort(std::begin(sorted), std::end(sorted), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+        printf("%-24s%14s%10s\n", "opcode pair", "count", "share");
+        for (size_t i = 0; i < std::min(NumPairsShown, std::size(sorted)); ++i)
+        {
+            const auto& [count, pair] = sorted[i];
+            const std::string name = pair.first + " " + pair.second;
+            printf("%-24s%14llu%9.2f%%\n", name.c_str(), (unsigned long long)count, 100.0 * count / numPairs);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Log::Init();
+    Log::GetLogger()->set_level(spdlog::level::off);
+
+    std::vector<std::string> args;
+    bool reportPairs = false;
+    uint32_t repeats = DefaultRepeats;
+    std::filesystem::path jsonFile;
+    std::filesystem::path baselineFile;
+    std::filesystem::path movieFile;
+    double threshold = DefaultThreshold;
+    uint64_t cycles = DefaultCycles;
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            if (arg == "--pairs")
+            {
+                reportPairs = true;
+                continue;
+            }
+            if (arg.rfind("--", 0) != 0)
+            {
+                args.push_back(arg);
+                continue;
+            }
+
+            // Every other option takes a value
+            if (i + 1 >= argc)
+            {
+                PrintUsage();
+                return -1;
+            }
+
+            const std::string value = argv[++i];
+            if (arg == "--repeat")
+                repeats = (uint32_t)std::clamp<uint64_t>(ParseCount(value), 1, UINT32_MAX);
+            else if (arg == "--json")
+                jsonFile = value;
+            else if (arg == "--baseline")
+                baselineFile = value;
+            else if (arg == "--threshold")
+                threshold = ParsePercent(value);
+            else if (arg == "--movie")
+                movieFile = value;
+            else
+            {
+                PrintUsage();
+                return -1;
+            }
+        }
+
+        if (std::size(args) > 1)
+            cycles = ParseCount(args[1]);
+    }
+    catch (const std::exception&)
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    if (std::size(args) > 2)
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    const std::filesystem::path romDir = (std::size(args) > 0) ? args[0] : "Resources/Games";
+    std::error_code error;
+    if (!std::filesystem::is_directory(romDir, error))
+    {
+        fprintf(stderr, "Can't find rom directory %s\n", romDir.string().c_str());
+        return -1;
+    }
+
+    std::vector<std::filesystem::path> roms;
+    for (const auto& entry : std::filesystem::directory_iterator(romDir))
+    {
+        const auto ext = entry.path().extension();
+        if (ext == ".c8" || ext == ".ch8")
+            roms.push_back(entry.path());
+    }
+    std::sort(std::begin(roms), std::end(roms));
+
+    if (std::empty(roms))
+    {
+        fprintf(stderr, "No roms found in %s\n", romDir.string().c_str());
+        return -1;
+    }
+
+    if (!std::empty(movieFile))
+        return BenchMovie(movieFile, roms, repeats) ? 0 : 1;
+
+    if (reportPairs)
+    {
+        ReportOpcodePairs(roms, cycles);
+        return 0;
+    }
+
+    std::vector<RomResult> results;
+    std::vector<Summary> summaries;
+    for (uint32_t quirks = 0; quirks < NumQuirkProfiles; ++quirks)
+    {
+        // Times are in ns/instruction, speedups are relative to the first backend
+        printf("%-24s", ("quirks: " + GetQuirksName(quirks)).c_str());
+        for (const auto& info : Backends)
+            printf("%12s", info.name);
+        printf("%8s\n", "idle");
+
+        double logNsSums[std::size(Backends)] = {};
+        double logSpeedupSums[std::size(Backends)] = {};
+        size_t timedRoms = 0;
+        for (const auto& rom : roms)
+        {
+            printf("%-24s", rom.filename().string().c_str());
+
+            double ns[std::size(Backends)] = {};
+            double idleShare = 0.0;
+            for (size_t i = 0; i < std::size(Backends); ++i)
+            {
+                const RunResult run = RunRom(rom, Backends[i].backend, quirks, cycles, repeats);
+                // Every backend runs the same instructions, so they all park for the same share
+                idleShare = run.GetIdleShare();
+                results.push_back({ rom.filename().string(), i, quirks, run });
+
+                ns[i] = run.GetNsPerInstruction();
+                printf("%12.2f", ns[i]);
+            }
+
+            const bool timed = idleShare <= MaxIdleShare;
+            printf("%7.1f%%%s\n", idleShare * 100.0, timed ? "" : "  (parked, not in geomean)");
+            if (!timed)
+                continue;
+
+            for (size_t i = 0; i < std::size(Backends); ++i)
+            {
+                logNsSums[i] += std::log((ns[i] > 0.0) ? ns[i] : 1.0);
+                logSpeedupSums[i] += std::log((ns[i] > 0.0) ? ns[0] / ns[i] : 1.0);
+            }
+            ++timedRoms;
+        }
+
+        printf("%-24s", "geomean speedup");
+        const size_t numTimed = std::max<size_t>(timedRoms, 1);
+        for (size_t i = 0; i < std::size(Backends); ++i)
+        {
+            printf("%11.2fx", std::exp(logSpeedupSums[i] / numTimed));
+            summaries.push_back({ i, quirks, std::exp(logNsSums[i] / numTimed) });
+        }
+        printf("\n");
+
+        printf("%-24s", "geomean Minstr/s");
+        for (size_t i = 0; i < std::size(Backends); ++i)
+            printf("%12.1f", 1e3 / summaries[std::size(summaries) - std::size(Backends) + i].geomeanNs);
+        printf("\n\n");
+    }
+
+    // Opcode class loops run with the default quirks
+    std::vector<std::vector<double>> classCosts(std::size(Backends), std::vector<double>(std::size(OpcodeClasses)));
+    printf("%-24s", "opcode class (ns/instr)");
+    for (const auto& info : Backends)
+        printf("%12s", info.name);
+    printf("\n");
+    for (size_t c = 0; c < std::size(OpcodeClasses); ++c)
+    {
+        const auto rom = WriteOpcodeClassRom(OpcodeClasses[c]);
+        printf("%-24s", OpcodeClasses[c].name);
+        for (size_t i = 0; i < std::size(Backends); ++i)
+        {
+            classCosts[i][c] = RunRom(rom, Backends[i].backend, 0, cycles, repeats).GetNsPerInstruction();
+            printf("%12.2f", classCosts[i][c]);
+        }
+        printf("\n");
+        std::filesystem::remove(rom);
+    }
+
+    if (!std::empty(jsonFile))
+        WriteJson(jsonFile, cycles, results, classCosts, summaries);
+
+    if (!std::empty(baselineFile))
+    {
+        const auto baseline = ReadBaseline(baselineFile);
+        if (std::empty(baseline))
+        {
+            fprintf(stderr, "No results found in baseline %s\n", baselineFile.string().c_str());
+            return -1;
+        }
+
+        if (!CompareToBaseline(baseline, summaries, threshold))
+        {
+            printf("Slower than the baseline by more than %.1f%%\n", threshold);
+            return 1;
+        }
+    }
+
+    return 0;
+}
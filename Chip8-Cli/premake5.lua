@@ -0,0 +1,53 @@
+
+project "Chip8-Cli"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++17"
+    staticruntime "off"
+
+    targetdir (outputTargetDir)
+    objdir (outputObjDir)
+
+    -- Runs from the emulator project so the bundled roms resolve the same way
+    debugdir "%{wks.location}/Chip8-Emulator"
+
+    files {
+        "src/**.h",
+        "src/**.cpp"
+    }
+
+    includedirs {
+        "src",
+        "%{IncludeDir.Chip8Core}",
+        "%{IncludeDir.Spdlog}"
+    }
+
+    links {
+        "Chip8-Core"
+    }
+
+    filter "system:windows"
+		systemversion "latest"
+		staticruntime "On"
+
+    filter "system:linux"
+		-- AOT libraries are loaded with dlopen
+		links { "dl" }
+
+    filter { "configurations:Debug" }
+        symbols "On"
+        defines {
+            "LOGGING_ENABLED",
+            "ASSERTS_ENABLED"
+        }
+
+    filter { "configurations:Release" }
+        symbols "On"
+        optimize "On"
+        defines {
+            "LOGGING_ENABLED",
+            "ASSERTS_ENABLED"
+        }
+
+    filter { "configurations:Dist" }
+        optimize "On"
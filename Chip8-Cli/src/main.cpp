@@ -0,0 +1,384 @@
+
+#include "Chip8.h"
+#include "HeadlessRunner.h"
+#include "Log.h"
+#include "Movie.h"
+#include "Utils/FileUtils.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Runs a rom headless and prints the state it ends in, for scripted runs and batch jobs on
+// machines without a display. The same rom, options and input script always end in the same
+// state, so the VRAM hash can be compared between runs.
+//
+// Usage: Chip8-Cli <rom> [--frames N | --cycles N] [--until exit|draw|pc=XXX]
+//                        [--input script] [--backend switch|table|block|jit|aot]
+//                        [--ips N] [--seed N] [--idle-skip 0|1]
+//                        [--record movie | --replay movie]
+//
+// Input scripts have one "<frame> <keys>" line per change of the held keys, where keys is a hex
+// mask with bit n set for key n, or - for none. Lines starting with # are ignored.
+//
+// --record runs the frames from the input script as a movie with a state hash per frame and
+// saves it. --replay plays a movie back with the settings it was made with, on whichever
+// backend is picked, and fails if the state ever differs from the movie. Movies run whole
+// frames, so they don't go with --cycles or --until.
+
+namespace
+{
+    constexpr uint32_t DefaultFrames = 600;
+
+    struct BackendInfo
+    {
+        Chip8::Backend backend;
+        const char* name;
+    };
+
+    constexpr BackendInfo Backends[] = {
+        { Chip8::Backend::eSwitch, "switch" },
+        { Chip8::Backend::eTable, "table" },
+        { Chip8::Backend::eBlockCache, "block" },
+        { Chip8::Backend::eJit, "jit" },
+        { Chip8::Backend::eAot, "aot" }
+    };
+
+    void PrintUsage()
+    {
+        fprintf(stderr, "Usage: Chip8-Cli <rom> [--frames N | --cycles N] [--until exit|draw|pc=XXX]\n"
+                        "                       [--input script] [--backend switch|table|block|jit|aot]\n"
+                        "                       [--ips N] [--seed N] [--idle-skip 0|1]\n"
+                        "                       [--record movie | --replay movie]\n");
+    }
+
+    // std::stoull stops at the first character it can't read and takes a minus sign, which would
+    // let "10k" through as 10 and "-1" as a huge count, so those throw too
+    uint64_t ParseNumber(const std::string& text, const int base = 10)
+    {
+        size_t end = 0;
+        const uint64_t value = std::stoull(text, &end, base);
+        if (end != std::size(text) || text[0] == '-')
+            throw std::invalid_argument(text);
+        return value;
+    }
+
+    // False for anything that isn't a hex number up to max
+    bool ParseHex(const std::string& text, const uint64_t max, uint64_t& value)
+    {
+        try
+        {
+            value = ParseNumber(text, 16);
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+        return value <= max;
+    }
+
+    bool ParseBackend(const std::string& name, Chip8::Backend& backend)
+    {
+        for (const auto& info : Backends)
+        {
+            if (name == info.name)
+            {
+                backend = info.backend;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool ParseInputScript(const std::filesystem::path& filepath, const uint64_t frameCycles, std::vector<HeadlessRunner::InputEvent>& script)
+    {
+        std::istringstream text(FileUtils::ReadText(filepath));
+        std::string line;
+        for (uint32_t lineNum = 1; std::getline(text, line); ++lineNum)
+        {
+            if (std::empty(line) || line[0] == '#')
+                continue;
+
+            std::istringstream fields(line);
+            uint64_t frame = 0;
+            std::string keys;
+            if (!(fields >> frame >> keys))
+            {
+                fprintf(stderr, "%s:%u: expected \"<frame> <keys>\"\n", filepath.string().c_str(), lineNum);
+                return false;
+            }
+
+            if (!std::empty(script) && frame * frameCycles < script.back().cycle)
+            {
+                fprintf(stderr, "%s:%u: frames have to be in order\n", filepath.string().c_str(), lineNum);
+                return false;
+            }
+
+            HeadlessRunner::InputEvent event;
+            event.cycle = frame * frameCycles;
+            uint64_t mask = 0;
+            if (keys != "-" && !ParseHex(keys, 0xFFFF, mask))
+            {
+                fprintf(stderr, "%s:%u: keys have to be a 16-bit hex mask or -\n", filepath.string().c_str(), lineNum);
+                return false;
+            }
+            event.keys = (uint16_t)mask;
+            script.push_back(event);
+        }
+        return true;
+    }
+
+    // Runs up to the number of frames through the movie, with the keys from the script while
+    // recording, and adds up the instructions run
+    HeadlessRunner::ExitReason RunMovie(Chip8& chip8, Movie& movie, const uint64_t frames,
+        const std::vector<HeadlessRunner::InputEvent>& script, uint64_t& cycles)
+    {
+        size_t nextInput = 0;
+        uint16_t keys = 0;
+        for (uint64_t frame = 0; frame < frames; ++frame)
+        {
+            while (nextInput < std::size(script) && script[nextInput].cycle <= frame)
+                keys = script[nextInput++].keys;
+
+            const uint64_t before = chip8.GetTotalCycles();
+            if (!movie.RunFrame(chip8, keys))
+                break;
+            // The count starts over when the game exits, so the frame it exits in isn't counted
+            if (std::empty(chip8.GetGameFile()))
+                return HeadlessRunner::ExitReason::eGameExited;
+
+            cycles += chip8.GetTotalCycles() - before;
+        }
+        return HeadlessRunner::ExitReason::eCyclesRun;
+    }
+
+    // FNV-1a over the packed VRAM of the current graphics mode
+    uint64_t HashVram(const Chip8& chip8)
+    {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (uint32_t i = 0; i < chip8.GetVramSize(); ++i)
+        {
+            hash ^= chip8.ReadVram(i);
+            hash *= 0x100000001B3ull;
+        }
+        return hash;
+    }
+
+    void PrintState(Chip8& chip8, const uint64_t cycles, const HeadlessRunner::ExitReason reason)
+    {
+        printf("exit:   %s\n", HeadlessRunner::GetExitReasonName(reason));
+        printf("cycles: %llu\n", (unsigned long long)cycles);
+        printf("idle:   %llu\n", (unsigned long long)chip8.GetIdleCycles());
+        printf("pc:     0x%03X\n", chip8.GetProgramCounter());
+        printf("i:      0x%03X\n", chip8.GetIndexReg());
+        printf("sp:     %u\n", chip8.GetStackPointer());
+        printf("dt:     %u\n", chip8.GetDelayTimer());
+        printf("st:     %u\n", chip8.GetSoundTimer());
+
+        printf("v:     ");
+        for (const uint8_t v : chip8.GetVReg())
+            printf(" %02X", v);
+        printf("\n");
+
+        printf("vram:   %016llx\n", (unsigned long long)HashVram(chip8));
+        printf("state:  %016llx\n", (unsigned long long)chip8.HashHotState());
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Log::Init();
+    Log::GetLogger()->set_level(spdlog::level::off);
+
+    if (argc < 2)
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    const std::filesystem::path rom = argv[1];
+    uint64_t frames = DefaultFrames;
+    uint64_t cycles = 0;
+    std::string until;
+    std::filesystem::path inputScript;
+    std::filesystem::path recordFile;
+    std::filesystem::path replayFile;
+    Chip8::Backend backend = Chip8::Backend::eTable;
+    uint32_t ips = Chip8::DEFAULT_INSTRUCTIONS_PER_SECOND;
+    uint64_t seed = 1;
+    bool idleSkipping = true;
+
+    for (int i = 2; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            PrintUsage();
+            return -1;
+        }
+
+        const std::string value = argv[++i];
+        try
+        {
+            if (arg == "--frames")
+                frames = ParseNumber(value);
+            else if (arg == "--cycles")
+                cycles = ParseNumber(value);
+            else if (arg == "--until")
+                until = value;
+            else if (arg == "--input")
+                inputScript = value;
+            else if (arg == "--ips")
+                ips = (uint32_t)std::min<uint64_t>(ParseNumber(value), UINT32_MAX);
+            else if (arg == "--seed")
+                seed = ParseNumber(value);
+            else if (arg == "--idle-skip")
+                idleSkipping = value != "0";
+            else if (arg == "--record")
+                recordFile = value;
+            else if (arg == "--replay")
+                replayFile = value;
+            else if (arg != "--backend" || !ParseBackend(value, backend))
+            {
+                PrintUsage();
+                return -1;
+            }
+        }
+        catch (const std::exception&)
+        {
+            PrintUsage();
+            return -1;
+        }
+    }
+
+    // The breakpoint is checked along with the rest of the options, before the rom is loaded
+    uint64_t breakpoint = 0;
+    bool validUntil = std::empty(until) || until == "exit" || until == "draw";
+    if (until.rfind("pc=", 0) == 0)
+        validUntil = ParseHex(until.substr(3), Chip8::MEM_SIZE - 1, breakpoint);
+    if (!validUntil)
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    const bool runMovie = !std::empty(recordFile) || !std::empty(replayFile);
+    if ((!std::empty(recordFile) && !std::empty(replayFile)) || (runMovie && (cycles != 0 || !std::empty(until))))
+    {
+        PrintUsage();
+        return -1;
+    }
+
+    if (!std::filesystem::is_regular_file(rom))
+    {
+        fprintf(stderr, "Can't find rom %s\n", rom.string().c_str());
+        return -1;
+    }
+
+    Chip8 chip8;
+    chip8.SetBackend(backend);
+    chip8.SetInstructionsPerSecond(ips);
+    chip8.SetIdleSkipping(idleSkipping);
+    chip8.SetRandomSeed(seed);
+    try
+    {
+        chip8.LoadGame(rom);
+    }
+    catch (const std::exception& e)
+    {
+        fprintf(stderr, "%s\n", e.what());
+        return -1;
+    }
+
+    if (runMovie)
+    {
+        std::vector<HeadlessRunner::InputEvent> script;
+        // Movie input is kept by frame, so the script's frames aren't turned into cycles
+        if (!std::empty(inputScript) && !ParseInputScript(inputScript, 1, script))
+            return -1;
+
+        Movie movie;
+        if (!std::empty(replayFile) && !movie.Load(replayFile))
+        {
+            fprintf(stderr, "Can't read movie %s\n", replayFile.string().c_str());
+            return -1;
+        }
+
+        const bool started = std::empty(replayFile) ? movie.StartRecording(chip8, true) : movie.StartPlayback(chip8);
+        if (!started)
+        {
+            fprintf(stderr, "Movie %s wasn't made with rom %s\n", replayFile.string().c_str(), rom.string().c_str());
+            return -1;
+        }
+
+        uint64_t movieCycles = 0;
+        const uint64_t movieFrames = std::empty(replayFile) ? frames : movie.GetNumFrames();
+        const HeadlessRunner::ExitReason reason = RunMovie(chip8, movie, movieFrames, script, movieCycles);
+        PrintState(chip8, movieCycles, reason);
+
+        if (std::empty(replayFile))
+        {
+            if (!movie.Save(recordFile))
+            {
+                fprintf(stderr, "Can't write movie %s\n", recordFile.string().c_str());
+                return -1;
+            }
+            printf("movie:  %llu frames recorded\n", (unsigned long long)movie.GetNumFrames());
+            return 0;
+        }
+
+        if (movie.GetDivergedFrame() != Movie::NO_FRAME)
+        {
+            printf("movie:  diverged at frame %llu of %llu\n", (unsigned long long)movie.GetDivergedFrame(),
+                (unsigned long long)movie.GetNumFrames());
+            return 1;
+        }
+
+        printf("movie:  %llu of %llu frames played%s\n", (unsigned long long)movie.GetFrame(),
+            (unsigned long long)movie.GetNumFrames(), movie.HasHashes() ? ", all matched" : "");
+        return 0;
+    }
+
+    HeadlessRunner runner(chip8);
+
+    // Frames are turned into cycles at the instruction rate so runs don't depend on timing
+    const uint64_t frameCycles = std::max<uint64_t>(chip8.GetInstructionsPerSecond() / chip8.GetFrameRate(), 1);
+    if (cycles == 0)
+        cycles = frames * frameCycles;
+
+    if (!std::empty(inputScript))
+    {
+        std::vector<HeadlessRunner::InputEvent> script;
+        if (!ParseInputScript(inputScript, frameCycles, script))
+            return -1;
+        runner.SetInputScript(script);
+    }
+
+    HeadlessRunner::ExitReason reason;
+    if (std::empty(until))
+    {
+        reason = runner.RunFor(cycles);
+    }
+    else if (until == "exit")
+    {
+        reason = runner.RunUntil(HeadlessRunner::Event::eGameExit, cycles);
+    }
+    else if (until == "draw")
+    {
+        reason = runner.RunUntil(HeadlessRunner::Event::eScreenChange, cycles);
+    }
+    else
+    {
+        runner.SetBreakpoint((uint16_t)breakpoint);
+        reason = runner.RunUntil(HeadlessRunner::Event::eBreakpoint, cycles);
+    }
+
+    PrintState(chip8, runner.GetCycles(), reason);
+    return 0;
+}
@@ -0,0 +1,46 @@
+
+project "Chip8-Core"
+    kind "StaticLib"
+    language "C++"
+    cppdialect "C++17"
+    staticruntime "off"
+
+    targetdir (outputTargetDir)
+    objdir (outputObjDir)
+
+    files {
+        "src/**.h",
+        "src/**.cpp"
+    }
+
+    includedirs {
+        "src",
+        "%{IncludeDir.Spdlog}"
+    }
+
+    filter "system:windows"
+		systemversion "latest"
+		staticruntime "On"
+		-- The instruction table is generated at compile time
+		buildoptions { "/constexpr:steps10000000" }
+
+    filter { "system:linux", "toolset:clang" }
+		buildoptions { "-fconstexpr-steps=10000000" }
+
+    filter { "configurations:Debug" }
+        symbols "On"
+        defines {
+            "LOGGING_ENABLED",
+            "ASSERTS_ENABLED"
+        }
+
+    filter { "configurations:Release" }
+        symbols "On"
+        optimize "On"
+        defines {
+            "LOGGING_ENABLED",
+            "ASSERTS_ENABLED"
+        }
+
+    filter { "configurations:Dist" }
+        optimize "On"
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Types.h"
+
+#include <cstddef>
+#include <filesystem>
+
+/*
+ * C ABI between the emulator and the shared libraries written by Chip8-Aot.
+ *
+ * A library exports CHIP8_AOT_GET_MODULE_INFO, which describes the rom it was compiled from
+ * and one function per basic block. A block can be entered at any of its instructions, so the
+ * module lists an entry for each of them with the index to start at and the number of
+ * instructions from there to the end. A block function runs against the state pointers and
+ * returns the number of instructions it executed, which is only less than the entry length
+ * when a store overwrote code. Only the C types below cross the boundary so a library built by
+ * any compiler can be loaded.
+ *
+ * The definitions are kept in a macro so the recompiler can paste the exact same text into the
+ * code it generates.
+ */
+#define CHIP8_AOT_ABI_VERSION 2
+#define CHIP8_AOT_GET_MODULE_INFO "Chip8AotGetModuleInfo"
+
+#define CHIP8_AOT_ABI_DEFINITIONS \
+    typedef struct Chip8AotState \
+    { \
+        void* chip8; \
+        unsigned char* memory; \
+        unsigned char* v; \
+        unsigned short* stack; \
+        unsigned short* indexReg; \
+        unsigned short* pc; \
+        unsigned short* sp; \
+        unsigned short* opcode; \
+        unsigned char* delayTimer; \
+        const unsigned char* codeModified; \
+        const unsigned char* useVYForShiftQuirk; \
+        void (*execute)(void* chip8, unsigned short opcode); \
+    } Chip8AotState; \
+    typedef unsigned int (*Chip8AotBlockFunc)(const Chip8AotState* state, unsigned int entry); \
+    typedef struct Chip8AotBlock \
+    { \
+        unsigned short startPC; \
+        unsigned short length; \
+        unsigned int entry; \
+        Chip8AotBlockFunc func; \
+    } Chip8AotBlock; \
+    typedef struct Chip8AotModuleInfo \
+    { \
+        unsigned int abiVersion; \
+        unsigned int romSize; \
+        unsigned long long romHash; \
+        unsigned int numBlocks; \
+        const Chip8AotBlock* blocks; \
+    } Chip8AotModuleInfo; \
+    typedef const Chip8AotModuleInfo* (*Chip8AotGetModuleInfoFunc)(void);
+
+extern "C"
+{
+    CHIP8_AOT_ABI_DEFINITIONS
+}
+
+#define CHIP8_AOT_STRINGIFY(...) #__VA_ARGS__
+#define CHIP8_AOT_EXPAND_AND_STRINGIFY(...) CHIP8_AOT_STRINGIFY(__VA_ARGS__)
+#define CHIP8_AOT_ABI_SOURCE CHIP8_AOT_EXPAND_AND_STRINGIFY(CHIP8_AOT_ABI_DEFINITIONS)
+
+// FNV-1a hash of the rom bytes, used to make sure a library is only run against its own rom
+inline uint64_t HashAotRom(const uint8_t* const data, const size_t size)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= data[i];
+        hash *= 0x100000001B3ull;
+    }
+
+    return hash;
+}
+
+// Where the library for a rom is expected, next to the rom with the platform's extension
+inline std::filesystem::path GetAotLibraryPath(const std::filesystem::path& game)
+{
+    std::filesystem::path library = game;
+#ifdef _WIN32
+    library.replace_extension(".dll");
+#else
+    library.replace_extension(".so");
+#endif
+    return library;
+}
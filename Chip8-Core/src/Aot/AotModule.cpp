@@ -0,0 +1,224 @@
+#include "AotModule.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#   include <Windows.h>
+#else
+#   include <dlfcn.h>
+#endif
+
+namespace
+{
+    constexpr uint16_t ROM_START = 0x200;
+
+    // Paths are made absolute so the loader doesn't search its own directories for them
+    void* OpenLibrary(const std::filesystem::path& path)
+    {
+        const std::filesystem::path absolute = std::filesystem::absolute(path);
+#ifdef _WIN32
+        return LoadLibraryW(absolute.c_str());
+#else
+        return dlopen(absolute.c_str(), RTLD_NOW | RTLD_LOCAL);
+#endif
+    }
+
+    void* FindSymbol(void* library, const char* name)
+    {
+#ifdef _WIN32
+        return (void*)GetProcAddress((HMODULE)library, name);
+#else
+        return dlsym(library, name);
+#endif
+    }
+
+    void CloseLibrary(void* library)
+    {
+#ifdef _WIN32
+        FreeLibrary((HMODULE)library);
+#else
+        dlclose(library);
+#endif
+    }
+}
+
+AotModule::AotModule(Chip8& chip8) :
+    mChip8(chip8)
+{
+    mState.chip8 = &chip8;
+    mState.memory = std::data(chip8.mMemory);
+    mState.v = std::data(chip8.mHot.v);
+    mState.stack = std::data(chip8.mHot.stack);
+    mState.indexReg = &chip8.mHot.indexReg;
+    mState.pc = &chip8.mHot.pc;
+    mState.sp = &chip8.mHot.sp;
+    mState.opcode = &chip8.mHot.opcode;
+    mState.delayTimer = &chip8.mHot.delayTimer;
+    mState.codeModified = (const unsigned char*)&chip8.mCodeModified;
+    mState.useVYForShiftQuirk = (const unsigned char*)&chip8.mUseVYForShiftQuirk;
+    mState.execute = &AotModule::ExecuteHandler;
+}
+
+AotModule::~AotModule()
+{
+    Unload();
+}
+
+bool AotModule::Load(const std::filesystem::path& library, const uint32_t romSize)
+{
+    Unload();
+
+    void* handle = OpenLibrary(library);
+    if (!handle)
+    {
+        LOG_ERROR("Failed to load recompiled rom {0}", library.string());
+        return false;
+    }
+
+    const auto getModuleInfo = (Chip8AotGetModuleInfoFunc)FindSymbol(handle, CHIP8_AOT_GET_MODULE_INFO);
+    const Chip8AotModuleInfo* info = getModuleInfo ? getModuleInfo() : nullptr;
+    if (!info || info->abiVersion != CHIP8_AOT_ABI_VERSION)
+    {
+        LOG_ERROR("{0} isn't a recompiled rom for this version of the emulator", library.string());
+        CloseLibrary(handle);
+        return false;
+    }
+
+    const uint8_t* rom = std::data(mChip8.mMemory) + ROM_START;
+    if (info->romSize != romSize || info->romHash != HashAotRom(rom, romSize))
+    {
+        LOG_WARN("{0} was recompiled from a different rom, ignoring it", library.string());
+        CloseLibrary(handle);
+        return false;
+    }
+
+    mLibrary = handle;
+    mInfo = info;
+    mRom.assign(rom, rom + romSize);
+    mBlocks.assign(Chip8::MEM_SIZE, nullptr);
+    mRomBlocks.assign(Chip8::MEM_SIZE, nullptr);
+
+    mMaxBlockSize = 0;
+    for (uint32_t i = 0; i < info->numBlocks; ++i)
+    {
+        const Chip8AotBlock& block = info->blocks[i];
+        const uint32_t size = block.length * 2u;
+        if (size > mMaxBlockSize)
+            mMaxBlockSize = size;
+
+        if (block.startPC >= ROM_START && block.startPC - ROM_START + size <= romSize)
+            mRomBlocks[block.startPC] = &block;
+    }
+
+    InvalidateAll();
+
+    LOG_INFO("Loaded {0} recompiled blocks from {1}", info->numBlocks, library.string());
+    return true;
+}
+
+void AotModule::Unload()
+{
+    if (!mLibrary)
+        return;
+
+    CloseLibrary(mLibrary);
+    mLibrary = nullptr;
+    mInfo = nullptr;
+    mRom.clear();
+    mBlocks.clear();
+    mRomBlocks.clear();
+    mMaxBlockSize = 0;
+}
+
+uint32_t AotModule::Run(const uint32_t maxCycles)
+{
+    uint32_t cycles = 0;
+    while (cycles < maxCycles)
+    {
+        const Chip8AotBlock* block = mBlocks[mChip8.mHot.pc];
+        if (!block || block->length > maxCycles - cycles)
+            break;
+
+        mChip8.mCodeModified = false;
+        const uint32_t executed = block->func(&mState, block->entry);
+        if (executed == 0)
+            break;
+
+        cycles += executed;
+    }
+
+    return cycles;
+}
+
+void AotModule::Invalidate(const uint16_t address, const uint32_t size)
+{
+    const uint32_t romEnd = ROM_START + (uint32_t)std::size(mRom);
+    if (!mLibrary || address >= romEnd || address + size <= ROM_START)
+        return;
+
+    // Blocks are short, so only the ones starting up to a block's size before the write can overlap it
+    const uint32_t first = (address >= ROM_START + mMaxBlockSize) ? address - mMaxBlockSize + 1 : ROM_START;
+    const uint32_t last = (address + size < romEnd) ? address + size - 1 : romEnd - 1;
+    for (uint32_t pc = first; pc <= last; ++pc)
+    {
+        const Chip8AotBlock* block = mBlocks[pc];
+        if (block && address < pc + block->length * 2u)
+        {
+            mBlocks[pc] = nullptr;
+            mChip8.mCodeModified = true;
+        }
+    }
+}
+
+void AotModule::InvalidateAll()
+{
+    if (!mLibrary)
+        return;
+
+    std::fill(std::begin(mBlocks), std::end(mBlocks), nullptr);
+
+    for (uint32_t i = 0; i < mInfo->numBlocks; ++i)
+    {
+        const Chip8AotBlock& block = mInfo->blocks[i];
+        const uint32_t offset = block.startPC - ROM_START;
+        const uint32_t size = block.length * 2u;
+        if (block.startPC < ROM_START || offset + size > std::size(mRom))
+            continue;
+
+        if (memcmp(std::data(mChip8.mMemory) + block.startPC, std::data(mRom) + offset, size) == 0)
+            mBlocks[block.startPC] = &block;
+    }
+
+    mChip8.mCodeModified = true;
+}
+
+void AotModule::Revalidate(const uint16_t address, const uint32_t size)
+{
+    const uint32_t romEnd = ROM_START + (uint32_t)std::size(mRom);
+    if (!mLibrary || address >= romEnd || address + size <= ROM_START)
+        return;
+
+    const uint32_t first = (address >= ROM_START + mMaxBlockSize) ? address - mMaxBlockSize + 1 : ROM_START;
+    const uint32_t last = (address + size < romEnd) ? address + size - 1 : romEnd - 1;
+    for (uint32_t pc = first; pc <= last; ++pc)
+    {
+        const Chip8AotBlock* block = mRomBlocks[pc];
+        if (!block || mBlocks[pc] || pc + block->length * 2u <= address)
+            continue;
+
+        if (memcmp(std::data(mChip8.mMemory) + pc, std::data(mRom) + (pc - ROM_START), block->length * 2u) == 0)
+            mBlocks[pc] = block;
+    }
+}
+
+void AotModule::ExecuteHandler(void* chip8, unsigned short opcode)
+{
+    Chip8* const c = (Chip8*)chip8;
+    const Chip8::Instruction& op = Chip8::sInstructionTable[opcode];
+
+    c->mHot.opcode = opcode;
+    c->ExecuteHandler(op);
+}
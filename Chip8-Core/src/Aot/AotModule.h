@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Chip8.h"
+#include "Aot/AotAbi.h"
+
+#include <vector>
+#include <filesystem>
+
+/*
+ * Runs blocks of a rom recompiled ahead of time by Chip8-Aot.
+ *
+ * The library is only used for the rom it was built from. A block is dropped as soon as any of
+ * its bytes are written, and every block is checked against the rom again when the whole
+ * memory is replaced, so self-modified code and anything the recompiler couldn't reach (computed
+ * jumps, code outside the rom) runs on the interpreter.
+ */
+class AotModule
+{
+public:
+    AotModule(Chip8& chip8);
+    ~AotModule();
+
+    AotModule(const AotModule&) = delete;
+    AotModule& operator=(const AotModule&) = delete;
+
+    // Loads the library for the rom of romSize bytes currently in memory at 0x200
+    bool Load(const std::filesystem::path& library, const uint32_t romSize);
+    void Unload();
+    bool IsLoaded() const { return mLibrary != nullptr; }
+
+    // Runs recompiled blocks from the PC. Returns the number of instructions executed, which is
+    // 0 when there is no valid block at the PC or it is longer than the budget.
+    uint32_t Run(const uint32_t maxCycles);
+
+    // Drops every block overlapping the written range [address, address + size)
+    void Invalidate(const uint16_t address, const uint32_t size);
+    // Checks every block against the rom again after the whole memory changed
+    void InvalidateAll();
+    // Brings back the dropped blocks overlapping [address, address + size) whose bytes match the
+    // rom again, like after undoing writes
+    void Revalidate(const uint16_t address, const uint32_t size);
+
+private:
+    static void ExecuteHandler(void* chip8, unsigned short opcode);
+
+private:
+    Chip8& mChip8;
+
+    void* mLibrary = nullptr;
+    const Chip8AotModuleInfo* mInfo = nullptr;
+    Chip8AotState mState = {};
+
+    // The rom the library was compiled from
+    std::vector<uint8_t> mRom;
+    // Blocks keyed by start PC, null where there is none or it was invalidated
+    std::vector<const Chip8AotBlock*> mBlocks;
+    // Every block that fits in the rom keyed by start PC, invalidated or not
+    std::vector<const Chip8AotBlock*> mRomBlocks;
+    uint32_t mMaxBlockSize = 0;
+};
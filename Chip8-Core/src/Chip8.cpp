@@ -0,0 +1,2229 @@
+
+#include "Chip8.h"
+
+#include "Log.h"
+#include "Aot/AotModule.h"
+#include "Jit/JitCompiler.h"
+#include "SaveSlotStore.h"
+#include "SaveStateFile.h"
+#include "Utils/Hash.h"
+#include "Utils/StringUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+    constexpr std::array<uint8_t, 240> FontSet =
+    {
+        0xF0, 0x90, 0x90, 0x90, 0xF0, //0
+        0x20, 0x60, 0x20, 0x20, 0x70, //1
+        0xF0, 0x10, 0xF0, 0x80, 0xF0, //2
+        0xF0, 0x10, 0xF0, 0x10, 0xF0, //3
+        0x90, 0x90, 0xF0, 0x10, 0x10, //4
+        0xF0, 0x80, 0xF0, 0x10, 0xF0, //5
+        0xF0, 0x80, 0xF0, 0x90, 0xF0, //6
+        0xF0, 0x10, 0x20, 0x40, 0x40, //7
+        0xF0, 0x90, 0xF0, 0x90, 0xF0, //8
+        0xF0, 0x90, 0xF0, 0x10, 0xF0, //9
+        0xF0, 0x90, 0xF0, 0x90, 0x90, //A
+        0xE0, 0x90, 0xE0, 0x90, 0xE0, //B
+        0xF0, 0x80, 0x80, 0x80, 0xF0, //C
+        0xE0, 0x90, 0x90, 0x90, 0xE0, //D
+        0xF0, 0x80, 0xF0, 0x80, 0xF0, //E
+        0xF0, 0x80, 0xF0, 0x80, 0x80, //F
+
+        // high-res mode font sprites
+        0xFF, 0xFF, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, // 0
+        0x18, 0x78, 0x78, 0x18, 0x18, 0x18, 0x18, 0x18, 0xFF, 0xFF, // 1
+        0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // 2
+        0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 3
+        0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0x03, 0x03, // 4
+        0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 5
+        0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, // 6
+        0xFF, 0xFF, 0x03, 0x03, 0x06, 0x0C, 0x18, 0x18, 0x18, 0x18, // 7
+        0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, // 8
+        0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, // 9
+        0x7E, 0xFF, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3, // A
+        0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, // B
+        0x3C, 0xFF, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0xFF, 0x3C, // C
+        0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC, // D
+        0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, // E
+        0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0  // F
+    };
+}
+
+Chip8::Chip8()
+{
+    mRandomSeed = (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+    mSaveSlots = CreateScope<SaveSlotStore>();
+
+    UpdateQuirkProfile();
+    Init();
+}
+
+Chip8::~Chip8() = default;
+
+void Chip8::Init()
+{
+    mMemory.fill(0);
+    mHot.v.fill(0);
+    mHot.stack.fill(0);
+    mHot.keys = 0;
+
+    mVram.fill(0);
+    mDirtyRows = ~0ull;
+
+    mHot.opcode = 0;
+
+    mHot.indexReg = 0;
+    mHot.sp = 0;
+    mHot.pc = 0x200;
+
+    mHot.delayTimer = 0;
+    mHot.soundTimer = 0;
+    mHot.rpl.fill(0);
+    mHot.graphicsMode = GraphicsMode::e64x32;
+
+    SetRandomSeed(mRandomSeed);
+
+    mFrameRate = 60;
+
+    mCycleClock = 0;
+    mTimerClock = 0;
+    mTotalCycles = 0;
+    mIdleCycles = 0;
+    mHot.waitingForKey = false;
+    // A game exiting in the frames ahead hasn't exited for real, and the checkpoint doesn't
+    // hold the profile
+    if (!mRunningAhead)
+        ResetProfile();
+
+    mHot.redraw = true;
+
+    memcpy(std::data(mMemory), std::data(FontSet), std::size(FontSet));
+
+    InvalidateAllBlocks();
+}
+
+constexpr Chip8::Instruction Chip8::Decode(const uint16_t opcode)
+{
+    Instruction op;
+    op.opcode = opcode;
+    op.nnn = opcode & 0x0FFF;
+    op.nn = opcode & 0x00FF;
+    op.x = (opcode & 0x0F00) >> 8;
+    op.y = (opcode & 0x00F0) >> 4;
+    op.id = Op::eUnknown;
+
+    switch (opcode & 0xF000)
+    {
+    case 0x0000:
+    {
+        switch (opcode)
+        {
+        case 0x00E0: op.id = Op::eClearScreen; break;
+        case 0x00EE: op.id = Op::eReturn; break;
+        case 0x00FF: op.id = Op::eEnableHighRes; break;
+        case 0x00FE: op.id = Op::eDisableHighRes; break;
+        case 0x00FB: op.id = Op::eScrollRight; break;
+        case 0x00FC: op.id = Op::eScrollLeft; break;
+        case 0x00FD: op.id = Op::eExit; break;
+        default:
+            if ((opcode & 0xFFF0) == 0x00C0)
+                op.id = Op::eScrollDown;
+            break;
+        }
+    }
+    break;
+
+    case 0x1000: op.id = Op::eJump; break;
+    case 0x2000: op.id = Op::eCall; break;
+    case 0x3000: op.id = Op::eSkipIfEqualImm; break;
+    case 0x4000: op.id = Op::eSkipIfNotEqualImm; break;
+    case 0x5000: op.id = Op::eSkipIfEqualReg; break;
+    case 0x6000: op.id = Op::eLoadImm; break;
+    case 0x7000: op.id = Op::eAddImm; break;
+
+    case 0x8000:
+    {
+        switch (opcode & 0x000F)
+        {
+        case 0x0000: op.id = Op::eMove; break;
+        case 0x0001: op.id = Op::eOr; break;
+        case 0x0002: op.id = Op::eAnd; break;
+        case 0x0003: op.id = Op::eXor; break;
+        case 0x0004: op.id = Op::eAddReg; break;
+        case 0x0005: op.id = Op::eSub; break;
+        case 0x0006: op.id = Op::eShiftRight; break;
+        case 0x0007: op.id = Op::eSubReverse; break;
+        case 0x000E: op.id = Op::eShiftLeft; break;
+        }
+    }
+    break;
+
+    case 0x9000: op.id = Op::eSkipIfNotEqualReg; break;
+    case 0xA000: op.id = Op::eLoadIndex; break;
+    case 0xB000: op.id = Op::eJumpOffset; break;
+    case 0xC000: op.id = Op::eRandom; break;
+    case 0xD000: op.id = Op::eDraw; break;
+
+    case 0xE000:
+    {
+        switch (opcode & 0x00FF)
+        {
+        case 0x009E: op.id = Op::eSkipIfKey; break;
+        case 0x00A1: op.id = Op::eSkipIfNotKey; break;
+        }
+    }
+    break;
+
+    case 0xF000:
+    {
+        switch (opcode & 0x00FF)
+        {
+        case 0x0007: op.id = Op::eLoadDelayTimer; break;
+        case 0x000A: op.id = Op::eWaitKey; break;
+        case 0x0015: op.id = Op::eSetDelayTimer; break;
+        case 0x0018: op.id = Op::eSetSoundTimer; break;
+        case 0x001E: op.id = Op::eAddIndex; break;
+        case 0x0029: op.id = Op::eLoadFont; break;
+        case 0x0030: op.id = Op::eLoadHiResFont; break;
+        case 0x0033: op.id = Op::eStoreBcd; break;
+        case 0x0055: op.id = Op::eStoreRegs; break;
+        case 0x0065: op.id = Op::eLoadRegs; break;
+        case 0x0075: op.id = Op::eSaveFlags; break;
+        case 0x0085: op.id = Op::eRestoreFlags; break;
+        }
+    }
+    break;
+    }
+
+    return op;
+}
+
+constexpr Chip8::InstructionTable Chip8::BuildInstructionTable()
+{
+    InstructionTable table = {};
+    for (uint32_t opcode = 0; opcode < std::size(table); ++opcode)
+        table[opcode] = Decode((uint16_t)opcode);
+
+    return table;
+}
+
+// Every possible opcode is decoded at compile time so a cycle is a single lookup and indirect call
+constexpr Chip8::InstructionTable Chip8::sInstructionTable = Chip8::BuildInstructionTable();
+
+template <typename Quirks>
+constexpr Chip8::HandlerTable Chip8::BuildHandlerTable()
+{
+    HandlerTable table = {};
+    table[(size_t)Op::eUnknown] = &Chip8::OpUnknown;
+    table[(size_t)Op::eClearScreen] = &Chip8::OpClearScreen;
+    table[(size_t)Op::eReturn] = &Chip8::OpReturn;
+    table[(size_t)Op::eEnableHighRes] = &Chip8::OpEnableHighRes;
+    table[(size_t)Op::eDisableHighRes] = &Chip8::OpDisableHighRes;
+    table[(size_t)Op::eScrollRight] = &Chip8::OpScrollRight;
+    table[(size_t)Op::eScrollLeft] = &Chip8::OpScrollLeft;
+    table[(size_t)Op::eScrollDown] = &Chip8::OpScrollDown;
+    table[(size_t)Op::eExit] = &Chip8::OpExit;
+    table[(size_t)Op::eJump] = &Chip8::OpJump;
+    table[(size_t)Op::eCall] = &Chip8::OpCall;
+    table[(size_t)Op::eSkipIfEqualImm] = &Chip8::OpSkipIfEqualImm;
+    table[(size_t)Op::eSkipIfNotEqualImm] = &Chip8::OpSkipIfNotEqualImm;
+    table[(size_t)Op::eSkipIfEqualReg] = &Chip8::OpSkipIfEqualReg;
+    table[(size_t)Op::eLoadImm] = &Chip8::OpLoadImm;
+    table[(size_t)Op::eAddImm] = &Chip8::OpAddImm;
+    table[(size_t)Op::eMove] = &Chip8::OpMove;
+    table[(size_t)Op::eOr] = &Chip8::OpOr;
+    table[(size_t)Op::eAnd] = &Chip8::OpAnd;
+    table[(size_t)Op::eXor] = &Chip8::OpXor;
+    table[(size_t)Op::eAddReg] = &Chip8::OpAddReg;
+    table[(size_t)Op::eSub] = &Chip8::OpSub;
+    table[(size_t)Op::eShiftRight] = &Chip8::OpShiftRight<Quirks>;
+    table[(size_t)Op::eSubReverse] = &Chip8::OpSubReverse;
+    table[(size_t)Op::eShiftLeft] = &Chip8::OpShiftLeft<Quirks>;
+    table[(size_t)Op::eSkipIfNotEqualReg] = &Chip8::OpSkipIfNotEqualReg;
+    table[(size_t)Op::eLoadIndex] = &Chip8::OpLoadIndex;
+    table[(size_t)Op::eJumpOffset] = &Chip8::OpJumpOffset<Quirks>;
+    table[(size_t)Op::eRandom] = &Chip8::OpRandom;
+    table[(size_t)Op::eDraw] = &Chip8::OpDraw;
+    table[(size_t)Op::eSkipIfKey] = &Chip8::OpSkipIfKey;
+    table[(size_t)Op::eSkipIfNotKey] = &Chip8::OpSkipIfNotKey;
+    table[(size_t)Op::eLoadDelayTimer] = &Chip8::OpLoadDelayTimer;
+    table[(size_t)Op::eWaitKey] = &Chip8::OpWaitKey;
+    table[(size_t)Op::eSetDelayTimer] = &Chip8::OpSetDelayTimer;
+    table[(size_t)Op::eSetSoundTimer] = &Chip8::OpSetSoundTimer;
+    table[(size_t)Op::eAddIndex] = &Chip8::OpAddIndex;
+    table[(size_t)Op::eLoadFont] = &Chip8::OpLoadFont;
+    table[(size_t)Op::eLoadHiResFont] = &Chip8::OpLoadHiResFont;
+    table[(size_t)Op::eStoreBcd] = &Chip8::OpStoreBcd;
+    table[(size_t)Op::eStoreRegs] = &Chip8::OpStoreRegs<Quirks>;
+    table[(size_t)Op::eLoadRegs] = &Chip8::OpLoadRegs<Quirks>;
+    table[(size_t)Op::eSaveFlags] = &Chip8::OpSaveFlags;
+    table[(size_t)Op::eRestoreFlags] = &Chip8::OpRestoreFlags;
+    return table;
+}
+
+template <typename Quirks>
+const Chip8::HandlerTable Chip8::sHandlerTable = Chip8::BuildHandlerTable<Quirks>();
+
+// Indexed from Op::eCount. None of the fused instructions depend on a quirk.
+const Chip8::FusedHandlerTable Chip8::sFusedHandlerTable = {
+    &Chip8::OpFusedLoadImmSetDelay,
+    &Chip8::OpFusedLoadImmSkipKey,
+    &Chip8::OpFusedLoadIndexAdd,
+    &Chip8::OpFusedAddSkipJump,
+    &Chip8::OpFusedDelaySkipJump
+};
+
+template <uint32_t... Flags>
+constexpr std::array<Chip8::QuirkProfileFuncs, sizeof...(Flags)> Chip8::BuildQuirkProfiles(std::integer_sequence<uint32_t, Flags...>)
+{
+    return { {
+        {
+            &sHandlerTable<QuirkProfile<Flags>>,
+            &Chip8::EmulateFrame<QuirkProfile<Flags>>,
+            &Chip8::EmulateBlock<QuirkProfile<Flags>>
+        }...
+    } };
+}
+
+// Every combination of quirks gets its own copy of the interpreter, picked when the settings change
+const std::array<Chip8::QuirkProfileFuncs, Chip8::NUM_QUIRK_PROFILES> Chip8::sQuirkProfiles =
+    Chip8::BuildQuirkProfiles(std::make_integer_sequence<uint32_t, Chip8::NUM_QUIRK_PROFILES>());
+
+void Chip8::UpdateQuirkProfile()
+{
+    uint32_t flags = 0;
+    if (mUseVYForShiftQuirk)
+        flags |= QUIRK_VY_FOR_SHIFT;
+    if (mUseBXNNQuirk)
+        flags |= QUIRK_BXNN;
+    if (mUseIndexIncrementAfterStoreLoadQuirk)
+        flags |= QUIRK_INDEX_INCREMENT;
+    if (mProfiling)
+        flags |= PROFILING;
+
+    mQuirkProfile = &sQuirkProfiles[flags];
+}
+
+void Chip8::Emulate(const TimeStep ts)
+{
+    mVramChanged = false;
+
+    if (std::empty(mGameFile))
+        return;
+
+    // With run-ahead the screen comes from the frames ahead, so these ones don't present
+    const bool runAhead = mRunAheadFrames > 0;
+    const bool coalesceFrames = mCoalesceFrames;
+    mCoalesceFrames |= runAhead;
+
+    if (mTurbo)
+    {
+        EmulateTurbo();
+    }
+    else
+    {
+        const float seconds = std::clamp(ts.GetSeconds(), 0.0f, MAX_TIME_STEP);
+        EmulateFor((uint64_t)std::llround(seconds * (double)NS_PER_SECOND));
+    }
+
+    mCoalesceFrames = coalesceFrames;
+
+    if (runAhead && !std::empty(mGameFile))
+        RunAhead();
+    else if (mHot.redraw || std::exchange(mShowingRunAhead, false))
+        PresentFrame();
+}
+
+void Chip8::Emulate()
+{
+    Emulate(TimeStep(1.0f / mFrameRate));
+}
+
+void Chip8::EmulateWithKeys(const uint16_t keys)
+{
+    UpdateInputFunc updateInputFunc;
+    std::swap(updateInputFunc, mUpdateInputFunc);
+    const bool turbo = std::exchange(mTurbo, false);
+
+    mHot.keys = keys;
+    Emulate();
+
+    mTurbo = turbo;
+    std::swap(updateInputFunc, mUpdateInputFunc);
+}
+
+uint32_t Chip8::Step(const uint32_t numCycles)
+{
+    mVramChanged = false;
+
+    if (std::empty(mGameFile) || numCycles == 0)
+        return 0;
+
+    // Just enough time for the cycle clock to reach numCycles, with what's left of a cycle after
+    // the last call already counted
+    const uint64_t rate = (uint64_t)mInstructionsPerSecond * GetEmuSpeedModifier();
+    const uint32_t cyclesRun = EmulateFor((numCycles * NS_PER_SECOND - mCycleClock + rate - 1) / rate);
+
+    if (mHot.redraw)
+        PresentFrame();
+
+    return cyclesRun;
+}
+
+uint32_t Chip8::EmulateFor(const uint64_t ns)
+{
+    mCycleClock += ns * mInstructionsPerSecond * GetEmuSpeedModifier();
+    const uint32_t numCycles = (uint32_t)(mCycleClock / NS_PER_SECOND);
+    mCycleClock %= NS_PER_SECOND;
+
+    mTimerClock += ns * TIMER_RATE;
+    const uint32_t numTicks = (uint32_t)(mTimerClock / NS_PER_SECOND);
+    mTimerClock %= NS_PER_SECOND;
+
+    const uint32_t cyclesRun = (this->*mQuirkProfile->emulateFrame)(numCycles, numTicks);
+    // A game exit has already reset the count
+    if (!std::empty(mGameFile))
+        mTotalCycles += cyclesRun;
+
+    return cyclesRun;
+}
+
+// Runs emulated frames back to back until the host time budget is spent. Only the last screen
+// is ever shown, so drawing instructions don't present on their own either.
+void Chip8::EmulateTurbo()
+{
+    using Clock = std::chrono::steady_clock;
+    const auto deadline = Clock::now() + std::chrono::duration<float>(TURBO_FRAME_BUDGET / mFrameRate);
+    // Rounded up so every frame ticks the timers once
+    const uint64_t frameNs = (NS_PER_SECOND + mFrameRate - 1) / mFrameRate;
+
+    const bool coalesceFrames = std::exchange(mCoalesceFrames, true);
+    do
+    {
+        // Reading the clock costs about as much as a frame of instructions
+        for (uint32_t i = 0; i < TURBO_FRAMES_PER_CLOCK_CHECK && !std::empty(mGameFile); ++i)
+            EmulateFor(frameNs);
+    } while (Clock::now() < deadline && !std::empty(mGameFile));
+    mCoalesceFrames = coalesceFrames;
+}
+
+void Chip8::RunAhead()
+{
+    TakeCheckpoint(mRunAheadCheckpoint);
+
+    // The frames ahead keep the keys held now and leave nothing behind, so they neither read
+    // input, log opcodes nor count towards the profile
+    UpdateInputFunc updateInputFunc;
+    OpcodeLogFunc opcodeLogFunc;
+    std::swap(updateInputFunc, mUpdateInputFunc);
+    std::swap(opcodeLogFunc, mOpcodeLogFunc);
+    const bool profiling = std::exchange(mProfiling, false);
+    UpdateQuirkProfile();
+    const bool coalesceFrames = std::exchange(mCoalesceFrames, true);
+
+    // The real frames' drawing is kept aside to tell whether the frames ahead drew as well
+    const bool realRedraw = std::exchange(mHot.redraw, false);
+    const uint64_t frameNs = (NS_PER_SECOND + mFrameRate - 1) / mFrameRate;
+    mRunningAhead = true;
+    for (uint32_t i = 0; i < mRunAheadFrames && !std::empty(mGameFile); ++i)
+        EmulateFor(frameNs);
+    mRunningAhead = false;
+
+    // A game that exits ahead shows its real screen until it exits for real. Otherwise the
+    // screen only needs presenting if something drew, or if the one shown has drawing from the
+    // last frames ahead that these ones may not repeat.
+    const bool exited = std::empty(mGameFile);
+    const bool aheadRedraw = mHot.redraw;
+    if (!exited && (realRedraw || aheadRedraw || mShowingRunAhead))
+    {
+        PresentFrame();
+        mShowingRunAhead = aheadRedraw;
+    }
+
+    mCoalesceFrames = coalesceFrames;
+    mProfiling = profiling;
+    UpdateQuirkProfile();
+    std::swap(opcodeLogFunc, mOpcodeLogFunc);
+    std::swap(updateInputFunc, mUpdateInputFunc);
+
+    RestoreCheckpoint(mRunAheadCheckpoint);
+    // The screen shown already has whatever the real frames drew
+    if (exited)
+    {
+        PresentFrame();
+        mShowingRunAhead = false;
+    }
+    else
+    {
+        mHot.redraw = false;
+    }
+}
+
+// Spreads the cycles evenly between the timer ticks, so a delay timer poll sees the timer count
+// down at the same pace whatever the instruction rate. Each tick is split again at the input
+// samples, which are the only points the keys change. Returns the cycles run, which falls short
+// only when the game exits.
+template <typename Quirks>
+uint32_t Chip8::EmulateFrame(const uint32_t numCycles, const uint32_t numTicks)
+{
+    const uint32_t numSlices = std::max(numTicks, 1u) * mInputSamplesPerTick;
+    uint32_t done = 0;
+    for (uint32_t slice = 0; slice < numSlices; ++slice)
+    {
+        if (mUpdateInputFunc)
+            mUpdateInputFunc(mHot.keys);
+
+        const uint32_t end = (uint32_t)((uint64_t)numCycles * (slice + 1) / numSlices);
+        const uint32_t cyclesRun = EmulateCycles<Quirks>(end - done);
+        if (cyclesRun < end - done)
+            return done + cyclesRun;
+        done = end;
+
+        if (numTicks > 0 && (slice + 1) % mInputSamplesPerTick == 0)
+        {
+            TickTimers();
+
+            if constexpr (Quirks::Profiling)
+            {
+                mProfile.drawsPerFrame[mProfile.frameIndex] = mProfileFrameDraws;
+                mProfile.frameIndex = (mProfile.frameIndex + 1) % PROFILE_FRAMES;
+                mProfileFrameDraws = 0;
+            }
+        }
+    }
+
+    return numCycles;
+}
+
+template <typename Quirks>
+uint32_t Chip8::EmulateCycles(const uint32_t numCycles)
+{
+    uint32_t i = 0;
+    while (i < numCycles)
+    {
+        // Parked on FX0A, the rest of the slice passes without running anything. FX0A runs again
+        // once a key is down, so the key is stored the same way as without parking.
+        if (mHot.waitingForKey)
+        {
+            if (mHot.keys == 0)
+            {
+                const uint32_t parked = numCycles - i;
+                mIdleCycles += parked;
+                if constexpr (Quirks::Profiling)
+                {
+                    mProfile.pcCounts[mHot.pc] += parked;
+                    mProfile.classCounts[0xF] += parked;
+                    mProfile.totalCycles += parked;
+                }
+                return numCycles;
+            }
+
+            mHot.waitingForKey = false;
+        }
+
+        // The profiler and the opcode log need to see every instruction
+        if (!Quirks::Profiling && mIdleSkipping && !mOpcodeLogFunc && IsIdleLoopCandidate(mHot.pc))
+        {
+            i += SkipIdleLoop<Quirks>(numCycles - i);
+        }
+        else if (mBackend == Backend::eJit)
+        {
+            i += EmulateJit<Quirks>(numCycles - i);
+        }
+        else if (mBackend == Backend::eAot)
+        {
+            i += EmulateAot<Quirks>(numCycles - i);
+        }
+        else if (mBackend == Backend::eBlockCache)
+        {
+            i += EmulateBlock<Quirks>(numCycles - i);
+        }
+        else
+        {
+            EmulateCycle<Quirks>();
+            ++i;
+        }
+
+        if (mHot.redraw && !mCoalesceFrames)
+            PresentFrame();
+
+        // The game exited and reset everything, so the rest of the slice has nothing to run
+        if (std::empty(mGameFile))
+            break;
+    }
+
+    return i;
+}
+
+void Chip8::PresentFrame()
+{
+    mVramChanged = true;
+    ++mVramGeneration;
+    if (mRenderFunc)
+        mRenderFunc(GetVramImage());
+
+    mHot.redraw = false;
+}
+
+template <typename Quirks>
+void Chip8::EmulateCycle()
+{
+    mHot.opcode = GetOpcode();
+    mHot.pc += 2;
+
+    if (mBackend == Backend::eSwitch)
+        Execute<Quirks>(Decode(mHot.opcode));
+    else
+        Execute<Quirks>(sInstructionTable[mHot.opcode]);
+}
+
+// Runs the block starting at the PC, building it first if it isn't cached yet.
+// Returns the number of instructions executed.
+template <typename Quirks>
+uint32_t Chip8::EmulateBlock(const uint32_t maxCycles)
+{
+    mRetiredBlocks.clear();
+
+    if (std::empty(mBlocks))
+        mBlocks.resize(MEM_SIZE);
+
+    const BasicBlock* block = mBlocks[mHot.pc].get();
+    if (!block)
+        block = BuildBlock(mHot.pc);
+
+    mCodeModified = false;
+
+    uint32_t cycles = 0;
+    size_t next = 0;
+
+    // Fused handlers can't log or count each of their instructions or stop partway through them
+    if (!mOpcodeLogFunc && !Quirks::Profiling)
+    {
+        for (const Instruction& op : block->fused)
+        {
+            if (IsFused(op.id))
+            {
+                const uint32_t length = GetFusedLength(op.id);
+                if (cycles + length > maxCycles)
+                    break;
+
+                // Fused instructions never write memory
+                cycles += (this->*sFusedHandlerTable[(size_t)op.id - (size_t)Op::eCount])(op);
+                next += length;
+                if (cycles == maxCycles)
+                    return cycles;
+            }
+            else
+            {
+                mHot.opcode = op.opcode;
+                mHot.pc += 2;
+                Execute<Quirks>(op);
+                ++next;
+
+                // Stop early if the block just overwrote cached code, possibly itself
+                if (++cycles == maxCycles || mCodeModified)
+                    return cycles;
+            }
+        }
+    }
+
+    // The rest of the block one instruction at a time, when the budget ran out before a fused one
+    for (; next < std::size(block->instructions); ++next)
+    {
+        const Instruction& op = block->instructions[next];
+        mHot.opcode = op.opcode;
+        mHot.pc += 2;
+        Execute<Quirks>(op);
+
+        if (++cycles == maxCycles || mCodeModified)
+            break;
+    }
+
+    return cycles;
+}
+
+// Runs compiled code from the PC, or the block cache if the code there isn't compiled yet.
+// Returns the number of instructions executed.
+template <typename Quirks>
+uint32_t Chip8::EmulateJit(const uint32_t maxCycles)
+{
+    // The opcode log and the profiler need every instruction to go through its handler
+    if (mOpcodeLogFunc || Quirks::Profiling)
+        return EmulateBlock<Quirks>(maxCycles);
+
+    if (!mJit)
+        mJit = CreateScope<JitCompiler>(*this);
+
+    if (!mJit->IsAvailable())
+        return EmulateBlock<Quirks>(maxCycles);
+
+    mRetiredBlocks.clear();
+
+    if (std::empty(mBlocks))
+        mBlocks.resize(MEM_SIZE);
+
+    uint32_t cycles = mJitLockstep ? mJit->RunLockstep(maxCycles) : mJit->Run(maxCycles);
+
+    // Cold code, or a block longer than what's left of the budget, runs on the block cache
+    if (cycles < maxCycles)
+        cycles += EmulateBlock<Quirks>(maxCycles - cycles);
+
+    return cycles;
+}
+
+// Runs blocks from the recompiled rom library, or the block cache for code it doesn't cover.
+// Returns the number of instructions executed.
+template <typename Quirks>
+uint32_t Chip8::EmulateAot(const uint32_t maxCycles)
+{
+    // The opcode log and the profiler need every instruction to go through its handler
+    if (!mAot || mOpcodeLogFunc || Quirks::Profiling)
+        return EmulateBlock<Quirks>(maxCycles);
+
+    uint32_t cycles = mAot->Run(maxCycles);
+
+    // Computed jumps, self-modified code and blocks longer than what's left of the budget
+    if (cycles < maxCycles)
+        cycles += EmulateBlock<Quirks>(maxCycles - cycles);
+
+    return cycles;
+}
+
+template <typename Quirks>
+void Chip8::Execute(const Instruction& op)
+{
+    if constexpr (Quirks::Profiling)
+    {
+        ++mProfile.pcCounts[(uint16_t)(mHot.pc - 2)];
+        ++mProfile.classCounts[op.opcode >> 12];
+        ++mProfile.totalCycles;
+        if (op.id == Op::eDraw)
+            ++mProfileFrameDraws;
+    }
+
+    (this->*sHandlerTable<Quirks>[(size_t)op.id])(op);
+}
+
+void Chip8::SetProfiling(const bool b)
+{
+    mProfiling = b;
+    // The counters only take up memory while they're used
+    if (mProfiling)
+        mProfile.pcCounts.resize(MEM_SIZE);
+    else
+        mProfile.pcCounts = {};
+
+    ResetProfile();
+    UpdateQuirkProfile();
+}
+
+void Chip8::ResetProfile()
+{
+    std::fill(std::begin(mProfile.pcCounts), std::end(mProfile.pcCounts), 0);
+    mProfile.classCounts.fill(0);
+    mProfile.drawsPerFrame.fill(0);
+    mProfile.frameIndex = 0;
+    mProfile.totalCycles = 0;
+    mProfileFrameDraws = 0;
+}
+
+// Runs one time around the loop at the PC on the interpreter. If that left the loop where it
+// started with the same registers, every later time around will too until the timers tick or
+// the keys change, so those cycles are counted as run without running them. Returns the number
+// of cycles run or skipped.
+template <typename Quirks>
+uint32_t Chip8::SkipIdleLoop(const uint32_t maxCycles)
+{
+    const uint16_t startPC = mHot.pc;
+    const std::array<uint8_t, 16> v = mHot.v;
+    const uint16_t indexReg = mHot.indexReg;
+
+    // Skipping the jump back can lead past the part of the loop that was checked, so anything
+    // that isn't idle-safe ends the run
+    uint32_t cycles = 0;
+    do
+    {
+        EmulateCycle<Quirks>();
+        ++cycles;
+    } while (mHot.pc != startPC && mHot.pc >= startPC && mHot.pc < startPC + MAX_IDLE_LOOP_BYTES && cycles < maxCycles &&
+        IsIdleLoopSafe(sInstructionTable[GetOpcode()].id));
+
+    // Left the loop, like a delay timer poll finding the timer at 0
+    if (mHot.pc != startPC)
+        return cycles;
+
+    uint8_t& state = mIdleLoops[startPC];
+    if (mHot.v != v || mHot.indexReg != indexReg)
+    {
+        if (++state == IDLE_LOOP_CANDIDATE + MAX_IDLE_LOOP_FAILURES)
+            state = IDLE_LOOP_NONE;
+        return cycles;
+    }
+
+    state = IDLE_LOOP_CANDIDATE;
+
+    // Whole times around the loop only, so the PC ends up where it would have
+    const uint32_t skipped = (maxCycles - cycles) / cycles * cycles;
+    mIdleCycles += skipped;
+    return cycles + skipped;
+}
+
+// A loop can only be idle if it's a straight run of idle-safe instructions, possibly skipping
+// some of them, that ends in a jump back to its start
+bool Chip8::IsIdleLoopCandidate(const uint16_t startPC)
+{
+    if (std::empty(mIdleLoops))
+        mIdleLoops.resize(MEM_SIZE, IDLE_LOOP_UNKNOWN);
+
+    uint8_t& state = mIdleLoops[startPC];
+    if (state == IDLE_LOOP_UNKNOWN)
+    {
+        state = IDLE_LOOP_NONE;
+        for (uint32_t pc = startPC; pc < startPC + MAX_IDLE_LOOP_BYTES && pc + 1 < MEM_SIZE; pc += 2)
+        {
+            const Instruction& op = sInstructionTable[(mMemory[pc] << 8) | mMemory[pc + 1]];
+            if (!IsIdleLoopSafe(op.id))
+                break;
+
+            if (op.id == Op::eJump)
+            {
+                if (op.nnn == startPC)
+                    state = IDLE_LOOP_CANDIDATE;
+                break;
+            }
+        }
+    }
+
+    return state >= IDLE_LOOP_CANDIDATE;
+}
+
+// Forgets what was found about the loops that could overlap the written range
+void Chip8::InvalidateIdleLoops(const uint16_t address, const uint32_t size)
+{
+    if (std::empty(mIdleLoops))
+        return;
+
+    const uint32_t start = (address >= MAX_IDLE_LOOP_BYTES) ? address - MAX_IDLE_LOOP_BYTES : 0;
+    const uint32_t end = std::min<uint32_t>(address + size, MEM_SIZE);
+    std::fill(std::begin(mIdleLoops) + start, std::begin(mIdleLoops) + end, IDLE_LOOP_UNKNOWN);
+}
+
+void Chip8::TickTimers()
+{
+    if (mHot.delayTimer > 0)
+        --mHot.delayTimer;
+
+    if (mHot.soundTimer > 0)
+    {
+        if (--mHot.soundTimer == 0)
+        {
+            LOG_INFO("BEEP!");
+        }
+    }
+}
+
+void Chip8::OpClearScreen(const Instruction& op) // 0x00E0: Clears the screen
+{
+    mVram.fill(0);
+    mDirtyRows = ~0ull;
+    mHot.redraw = true;
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc("0x00E0: Clear Screen");
+}
+
+void Chip8::OpReturn(const Instruction& op) // 0x00EE: Returns from subroutine
+{
+    mHot.sp = (mHot.sp - 1) & 0xF;
+    mHot.pc = mHot.stack[mHot.sp];
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0x00EE: PC=%X", mHot.pc));
+}
+
+void Chip8::OpEnableHighRes(const Instruction& op) // 0x00FF: Enable 128x64 high res graphics mode
+{
+    ChangeGraphicsMode(GraphicsMode::e128x64);
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc("0x00FF: Enable high res");
+}
+
+void Chip8::OpDisableHighRes(const Instruction& op) // 0x00FE: Disable 128x64 high res graphics mode
+{
+    ChangeGraphicsMode(GraphicsMode::e64x32);
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc("0x00FE: Disable high res");
+}
+
+void Chip8::OpScrollRight(const Instruction& op) // 0x00FB: Scroll the display right by 4 pixels
+{
+    // TODO
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc("0x00FB: Scroll display right by 4 pixels");
+}
+
+void Chip8::OpScrollLeft(const Instruction& op) // 0x00FC: Scroll the display left by 4 pixels
+{
+    // TODO
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc("0x00FC: Scroll display left by 4 pixels");
+}
+
+void Chip8::OpScrollDown(const Instruction& op) // 0x00CN Scroll the display down by 0 to 15 pixels
+{
+    // TODO
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0x00CN: Scroll display down N=%d", op.GetN()));
+}
+
+void Chip8::OpExit(const Instruction& op) // 0x00FD Exit the Chip8/SuperChip interpreter
+{
+    Init();
+    mGameFile = "";
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc("0x00FD: Exit Chip8/Super Chip");
+}
+
+void Chip8::OpJump(const Instruction& op) // 0x1NNN Jump to address NNN
+{
+    mHot.pc = op.nnn;
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0x1NNN: Jump to address NNN=%X", op.nnn));
+}
+
+void Chip8::OpCall(const Instruction& op) // 0x2NNN Calls subroutine at NNN
+{
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0x2NNN: Calls subroutine PC(before)=%X NNN=%X", mHot.pc, op.nnn));
+    mHot.stack[mHot.sp & 0xF] = mHot.pc;
+    mHot.sp = (mHot.sp + 1) & 0xF;
+    mHot.pc = op.nnn;
+}
+
+void Chip8::OpSkipIfEqualImm(const Instruction& op) // 0x3XNN Skips next instruction if VX equals NN
+{
+    if (mHot.v[op.x] == op.nn)
+        mHot.pc += 2;
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0x3XNN: VX=%d NN=%d", mHot.v[op.x], op.nn));
+}
+
+void Chip8::OpSkipIfNotEqualImm(const Instruction& op) // 0x4XNN Skips next instruction if VX does not equal NN
+{
+    if (mHot.v[op.x] != op.nn)
+        mHot.pc += 2;
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0x4XNN: VX=%d NN=%d", mHot.v[op.x], op.nn));
+}
+
+void Chip8::OpSkipIfEqualReg(const Instruction& op) // 0x5XY0 Skips next instruction if VX equals VY
+{
+    if (mHot.v[op.x] == mHot.v[op.y])
+        mHot.pc += 2;
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0x5XY0: VX=%d VY=%d", mHot.v[op.x], mHot.v[op.y]));
+}
+
+void Chip8::OpLoadImm(const Instruction& op) // 0x6XNN Sets VX to NN
+{
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0x6XNN: VX(before)=%d NN=%d", mHot.v[op.x], op.nn));
+    mHot.v[op.x] = op.nn;
+}
+
+void Chip8::OpAddImm(const Instruction& op) // 0x7XNN Adds NN to VX (Carry flag is not changed)
+{
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0x7XNN: VX=%d NN=%d VX+NN=%d", mHot.v[op.x], op.nn, mHot.v[op.x] + op.nn));
+    mHot.v[op.x] += op.nn;
+}
+
+void Chip8::OpMove(const Instruction& op) // 0x8XY0 Set VX to VY
+{
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0x8XY0: VX=%d VY=%d", mHot.v[op.x], mHot.v[op.y]));
+    mHot.v[op.x] = mHot.v[op.y];
+}
+
+void Chip8::OpOr(const Instruction& op) // 0x8XY1 Set VX to VX or VY
+{
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0x8XY1: VX=%d VY=%d VX|VY=%d",
+            mHot.v[op.x], mHot.v[op.y], mHot.v[op.x] | mHot.v[op.y]));
+    mHot.v[op.x] |= mHot.v[op.y];
+}
+
+void Chip8::OpAnd(const Instruction& op) // 0x8XY2 Set VX to VX and VY
+{
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0x8XY2: VX=%d VY=%d VX&VY=%d",
+            mHot.v[op.x], mHot.v[op.y], mHot.v[op.x] & mHot.v[op.y]));
+    mHot.v[op.x] &= mHot.v[op.y];
+}
+
+void Chip8::OpXor(const Instruction& op) // 0x8XY3 Set VX to VX xor VY
+{
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0x8XY3: VX=%d VY=%d VX^VY=%d",
+            mHot.v[op.x], mHot.v[op.y], mHot.v[op.x] ^ mHot.v[op.y]));
+    mHot.v[op.x] ^= mHot.v[op.y];
+}
+
+void Chip8::OpAddReg(const Instruction& op) // 0x8XY4 Adds VY to VX. VF is set when there's a carry
+{
+    SetVF((mHot.v[op.x] + mHot.v[op.y]) > 0xFF ? 1 : 0);
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0x8XY4: VX=%d VY=%d VX+VY=%d VF=%d",
+            mHot.v[op.x], mHot.v[op.y], mHot.v[op.x] + mHot.v[op.y], GetVF()));
+    mHot.v[op.x] += mHot.v[op.y];
+}
+
+void Chip8::OpSub(const Instruction& op) // 0x8XY5 VY is subtracted from VX. VF is set to 0 if borrow
+{
+    SetVF(mHot.v[op.x] > mHot.v[op.y] ? 1 : 0);
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0x8XY5: VX=%d VY=%d VX-VY=%d VF=%d",
+            mHot.v[op.x], mHot.v[op.y], mHot.v[op.x] - mHot.v[op.y], GetVF()));
+    mHot.v[op.x] -= mHot.v[op.y];
+}
+
+template <typename Quirks>
+void Chip8::OpShiftRight(const Instruction& op) // 0x8XY6 Stores the least significant bit of VX in VF and then shifts VX to the right by 1.
+{
+    if constexpr (Quirks::UseVYForShift)
+        mHot.v[op.x] = mHot.v[op.y];
+
+    SetVF(mHot.v[op.x] & 0x1);
+    mHot.v[op.x] >>= 1;
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0x8XY6: VX=%d VF=%d", mHot.v[op.x], GetVF()));
+}
+
+void Chip8::OpSubReverse(const Instruction& op) // 0x8XY7 Sets VX to VY minus VX. VF is set to 0 when there's a borrow, and 1 when there isn't.
+{
+    SetVF(mHot.v[op.y] > mHot.v[op.x] ? 1 : 0);
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0x8XY7: VX=%d VY=%d VY-VX=%d VF=%d",
+            mHot.v[op.x], mHot.v[op.y], mHot.v[op.y] - mHot.v[op.x], GetVF()));
+    mHot.v[op.x] = mHot.v[op.y] - mHot.v[op.x];
+}
+
+template <typename Quirks>
+void Chip8::OpShiftLeft(const Instruction& op) // 0x8XYE Stores the most significant bit of VX in VF and then shifts VX to the left by 1.
+{
+    if constexpr (Quirks::UseVYForShift)
+        mHot.v[op.x] = mHot.v[op.y];
+
+    SetVF(mHot.v[op.x] >> 7);
+    mHot.v[op.x] <<= 1;
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0x8XYE: VX=%d VF=%d", mHot.v[op.x], GetVF()));
+}
+
+void Chip8::OpSkipIfNotEqualReg(const Instruction& op) // 0x9XY0 Skips the next instruction if VX does not equal VY
+{
+    if (mHot.v[op.x] != mHot.v[op.y])
+        mHot.pc += 2;
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0x9XY0: VX=%d VY=%d", mHot.v[op.x], mHot.v[op.y]));
+}
+
+void Chip8::OpLoadIndex(const Instruction& op) // 0xANNN Sets I to the address NNN
+{
+    mHot.indexReg = op.nnn;
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0xANNN: I=%X NNN=%X", mHot.indexReg, op.nnn));
+}
+
+template <typename Quirks>
+void Chip8::OpJumpOffset(const Instruction& op) // 0xBNNN Jumps to the address NNN plus V0
+{
+    if constexpr (Quirks::UseBXNN)
+        mHot.pc = op.nnn + mHot.v[op.x];
+    else
+        mHot.pc = op.nnn + mHot.v[0];
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0xBNNN: VX=%d V0=%d NNN=%X", mHot.v[op.x], mHot.v[0], op.nnn));
+}
+
+uint8_t Chip8::NextRandom()
+{
+    mHot.randomState ^= mHot.randomState >> 12;
+    mHot.randomState ^= mHot.randomState << 25;
+    mHot.randomState ^= mHot.randomState >> 27;
+    // The top bits of the product are the well mixed ones
+    return (uint8_t)((mHot.randomState * 0x2545F4914F6CDD1Dull) >> 56);
+}
+
+void Chip8::OpRandom(const Instruction& op) // 0xCXNN Sets VX to the result of bitwise and op on a random number and NN
+{
+    const uint8_t randVal = NextRandom();
+    mHot.v[op.x] = randVal & op.nn;
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0xCXNN: randVal=%d NN=%d", randVal, op.nn));
+}
+
+/*
+ * 0xDXYN
+ * Draws a sprite at coordinate (VX, VY) that has a width of 8 pixels and a height of N pixels.
+ * Each row of 8 pixels is read as bit-coded starting from memory location I; I value does not change
+ * after the execution of this instruction. As described above, VF is set to 1 if any screen pixels
+ * are flipped from set to unset when the sprite is drawn, and to 0 if that does not happen
+ */
+void Chip8::OpDraw(const Instruction& op)
+{
+    // The sprite starts at wrapped coordinates and is clipped at the right and bottom edges
+    const uint32_t width = GetScreenWidth();
+    const uint32_t height = GetScreenHeight();
+    const uint32_t wordsPerRow = width / 64;
+    const uint32_t xPos = mHot.v[op.x] & (width - 1);
+    const uint32_t yPos = mHot.v[op.y] & (height - 1);
+
+    // SuperChip draws 16x16 sprites from two bytes per row when N is 0 in 128x64
+    const bool isWide = mHot.graphicsMode == GraphicsMode::e128x64 && op.GetN() == 0;
+    const uint32_t spriteWidth = isWide ? 16 : 8;
+    const uint32_t numRows = std::min<uint32_t>(isWide ? 16 : op.GetN(), height - yPos);
+
+    uint64_t collision = 0;
+    for (uint32_t row = 0; row < numRows; ++row)
+    {
+        uint64_t sprite;
+        if (isWide)
+            sprite = (mMemory[(uint16_t)(mHot.indexReg + row * 2)] << 8) | mMemory[(uint16_t)(mHot.indexReg + row * 2 + 1)];
+        else
+            sprite = mMemory[(uint16_t)(mHot.indexReg + row)];
+
+        // Line the sprite up with the row, pixels past the right edge fall off the last word
+        sprite <<= 64 - spriteWidth;
+        const uint64_t left = (xPos < 64) ? sprite >> xPos : 0;
+        const uint64_t right = (xPos == 0) ? 0 : (xPos < 64) ? sprite << (64 - xPos) : sprite >> (xPos - 64);
+
+        uint64_t* const words = std::data(mVram) + (yPos + row) * wordsPerRow;
+        collision |= words[0] & left;
+        words[0] ^= left;
+        if (wordsPerRow == 2)
+        {
+            collision |= words[1] & right;
+            words[1] ^= right;
+        }
+    }
+
+    SetVF(collision != 0 ? 1 : 0);
+    mDirtyRows |= ((1ull << numRows) - 1) << yPos;
+
+    mHot.redraw = true;
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0xDXYN: N=%d", op.GetN()));
+}
+
+void Chip8::OpSkipIfKey(const Instruction& op) // 0xEX9E Skips the next instruction if the key stored in VX is pressed.
+{
+    if (IsKeyDown(mHot.v[op.x]))
+        mHot.pc += 2;
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0xEX9E: VX=%d Key[VX]=%d", mHot.v[op.x], IsKeyDown(mHot.v[op.x])));
+}
+
+void Chip8::OpSkipIfNotKey(const Instruction& op) // 0xEXA1 Skips the next instruction if the key stored in VX is not pressed.
+{
+    if (!IsKeyDown(mHot.v[op.x]))
+        mHot.pc += 2;
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0xEXA1: VX=%d Key[VX]=%d", mHot.v[op.x], IsKeyDown(mHot.v[op.x])));
+}
+
+void Chip8::OpLoadDelayTimer(const Instruction& op) // 0xFX07 Sets VX to the value of the delay timer.
+{
+    mHot.v[op.x] = mHot.delayTimer;
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0xFX07: DelayTimer=%d", mHot.delayTimer));
+}
+
+/*
+ * 0xFX0A A key press is awaited, and then stored in VX.
+ * (Blocking Operation. All instruction halted until next key event);
+ */
+void Chip8::OpWaitKey(const Instruction& op)
+{
+    const bool keyPressed = mHot.keys != 0;
+
+    // The lowest key down
+    for (uint8_t i = 0; keyPressed && i < 16; ++i)
+    {
+        if (IsKeyDown(i))
+        {
+            mHot.v[op.x] = i;
+            break;
+        }
+    }
+
+    // Runs again once a key is down
+    if (!keyPressed)
+    {
+        mHot.pc -= 2;
+        mHot.waitingForKey = true;
+    }
+
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0xFX0A: key pressed=%d", keyPressed));
+}
+
+void Chip8::OpSetDelayTimer(const Instruction& op) // 0xFX15 Sets delay timer to VX.
+{
+    mHot.delayTimer = mHot.v[op.x];
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0xFX15: DelayTimer=%d", mHot.delayTimer));
+}
+
+void Chip8::OpSetSoundTimer(const Instruction& op) // 0xFX18 Sets sound timer to VX.
+{
+    mHot.soundTimer = mHot.v[op.x];
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0xFX18: SoundTimer=%d", mHot.soundTimer));
+}
+
+void Chip8::OpAddIndex(const Instruction& op) // 0xFX1E Adds VX to I
+{
+    SetVF(mHot.indexReg + mHot.v[op.x] > 0x0FFF ? 1 : 0);
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0xFX1E: VX=%d I=%d VX+I=%X", mHot.v[op.x], mHot.indexReg, mHot.indexReg + mHot.v[op.x]));
+    mHot.indexReg += mHot.v[op.x];
+}
+
+void Chip8::OpLoadFont(const Instruction& op) // 0xFX29 Sets I to the location of the sprite for the character in VX. Characters 0-F (in hexadecimal) are represented by a 4x5 font.
+{
+    mHot.indexReg = mHot.v[op.x] * 5;
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0xFX29: VX=%d I=%d", mHot.v[op.x], mHot.indexReg));
+}
+
+void Chip8::OpLoadHiResFont(const Instruction& op) // 0xFX30 Set I to a large hex character based on the value of VX.
+{
+    mHot.indexReg = mHot.v[op.x] * 10 + 80; // 80 is the start of the hi res font
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0xFX30: VX=%d I=%d", mHot.v[op.x], mHot.indexReg));
+}
+
+/*
+ * 0xFX33
+ *
+ * Stores the binary-coded decimal representation of VX, with the most significant of three digits
+ * at the address in I, the middle digit at I plus 1, and the least significant digit at I plus 2.
+ * (In other words, take the decimal representation of VX, place the hundreds digit in memory at
+ * location in I, the tens digit at location I+1, and the ones digit at location I+2.)
+ */
+void Chip8::OpStoreBcd(const Instruction& op)
+{
+    const uint8_t vx = mHot.v[op.x];
+    mMemory[mHot.indexReg] = vx / 100;
+    mMemory[mHot.indexReg + 1] = (vx / 10) % 10;
+    mMemory[mHot.indexReg + 2] = (vx % 100) % 10;
+    InvalidateBlocks(mHot.indexReg, 3);
+
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0xFX33: VX=%d", vx));
+}
+
+template <typename Quirks>
+void Chip8::OpStoreRegs(const Instruction& op) // 0xFX55 Stores V0 to VX (including VX) in memory starting at address I
+{
+    memcpy(std::data(mMemory) + mHot.indexReg, std::data(mHot.v), op.x + 1);
+    InvalidateBlocks(mHot.indexReg, op.x + 1);
+
+    // On the original interpreter, when the operation is done, I = I + X + 1.
+    // Newer implementations do not increment the I
+    if constexpr (Quirks::UseIndexIncrementAfterStoreLoad)
+        mHot.indexReg += op.x + 1;
+
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0xFX55: I=%X X=%d", mHot.indexReg, op.x));
+}
+
+template <typename Quirks>
+void Chip8::OpLoadRegs(const Instruction& op) // 0xFX65 Fills V0 to VX (including VX) with values from memory starting at address I
+{
+    memcpy(std::data(mHot.v), std::data(mMemory) + mHot.indexReg, op.x + 1);
+
+    // On the original interpreter, when the operation is done, I = I + X + 1.
+    // Newer implementations do not increment the I
+    if constexpr (Quirks::UseIndexIncrementAfterStoreLoad)
+        mHot.indexReg += op.x + 1;
+
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0xFX65: I=%X X=%d", mHot.indexReg, op.x));
+}
+
+void Chip8::OpSaveFlags(const Instruction& op) // 0xFX75 Save V0-VX to flag registers
+{
+    memcpy(std::data(mHot.rpl), std::data(mHot.v), op.x + 1);
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0xFX75: size=%d", op.x + 1));
+}
+
+void Chip8::OpRestoreFlags(const Instruction& op) // 0xFX85 Restore V0-VX from flag registers
+{
+    memcpy(std::data(mHot.v), std::data(mHot.rpl), op.x + 1);
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0xFX85: size=%d", op.x + 1));
+}
+
+// Trap for any opcode the interpreter doesn't implement. The opcode is skipped.
+void Chip8::OpUnknown(const Instruction& op)
+{
+    if (mOpcodeLogFunc)
+        mOpcodeLogFunc(StringUtils::Format("0x%04X: Unknown opcode", op.opcode));
+}
+
+/*
+ * Fused instructions. Each one leaves the PC, opcode and registers exactly as running its
+ * instructions one by one would.
+ */
+
+uint32_t Chip8::OpFusedLoadImmSetDelay(const Instruction& op) // 6XNN FY15: the FY15, with the X and NN of the load in Y and NNN
+{
+    mHot.v[op.y] = (uint8_t)op.nnn;
+    mHot.pc += 2;
+
+    mHot.opcode = op.opcode;
+    mHot.pc += 2;
+    OpSetDelayTimer(op);
+    return 2;
+}
+
+uint32_t Chip8::OpFusedLoadImmSkipKey(const Instruction& op) // 6XNN EY9E/EYA1: the skip, with the X and NN of the load in Y and NNN
+{
+    mHot.v[op.y] = (uint8_t)op.nnn;
+    mHot.pc += 2;
+
+    mHot.opcode = op.opcode;
+    mHot.pc += 2;
+    if (op.nn == 0x9E)
+        OpSkipIfKey(op);
+    else
+        OpSkipIfNotKey(op);
+    return 2;
+}
+
+uint32_t Chip8::OpFusedLoadIndexAdd(const Instruction& op) // ANNN FX1E: the FX1E, with the NNN of the load
+{
+    mHot.indexReg = op.nnn;
+    mHot.pc += 2;
+
+    mHot.opcode = op.opcode;
+    mHot.pc += 2;
+    OpAddIndex(op);
+    return 2;
+}
+
+uint32_t Chip8::OpFusedAddSkipJump(const Instruction& op) // 7XNN 3XMM/4XMM 1NNN: the skip, with Y holding the added NN and NNN of the jump
+{
+    mHot.v[op.x] += op.y;
+    mHot.pc += 2;
+    return 1 + FinishFusedSkipJump(op);
+}
+
+uint32_t Chip8::OpFusedDelaySkipJump(const Instruction& op) // FX07 3XMM/4XMM 1NNN: the skip, with NNN of the jump
+{
+    mHot.v[op.x] = mHot.delayTimer;
+    mHot.pc += 2;
+    return 1 + FinishFusedSkipJump(op);
+}
+
+// Runs the skip of a fused instruction and the jump after it, if it isn't skipped
+uint32_t Chip8::FinishFusedSkipJump(const Instruction& op)
+{
+    const bool skipIfEqual = (op.opcode & 0xF000) == 0x3000;
+    mHot.pc += 2;
+    if ((mHot.v[op.x] == op.nn) == skipIfEqual)
+    {
+        mHot.opcode = op.opcode;
+        mHot.pc += 2;
+        return 1;
+    }
+
+    mHot.opcode = 0x1000 | op.nnn;
+    mHot.pc = op.nnn;
+    return 2;
+}
+
+Chip8::BasicBlock* Chip8::BuildBlock(const uint16_t startPC)
+{
+    auto block = CreateScope<BasicBlock>();
+    block->startPC = startPC;
+
+    uint32_t pc = startPC;
+    while (pc + 1 < MEM_SIZE && std::size(block->instructions) < MAX_BLOCK_LENGTH)
+    {
+        const Instruction& op = sInstructionTable[(mMemory[pc] << 8) | mMemory[pc + 1]];
+        block->instructions.push_back(op);
+        pc += 2;
+
+        if (EndsBlock(op))
+            break;
+    }
+
+    block->endPC = (uint16_t)(pc - 1);
+    FuseBlock(*block);
+
+    for (uint32_t page = startPC / BLOCK_PAGE_SIZE; page <= block->endPC / BLOCK_PAGE_SIZE; ++page)
+    {
+        mPageBlocks[page].push_back(startPC);
+        mCodePages.set(page);
+    }
+
+    mBlocks[startPC] = std::move(block);
+    return mBlocks[startPC].get();
+}
+
+// Peephole pass over a new block. The idioms are the pairs that run back to back the most in the
+// bundled roms, see Chip8-Bench --pairs, and all of them skip dispatches in tight loops.
+void Chip8::FuseBlock(BasicBlock& block) const
+{
+    const auto& instructions = block.instructions;
+    const size_t count = std::size(instructions);
+
+    block.fused.clear();
+    block.fused.reserve(count);
+
+    for (size_t i = 0; i < count;)
+    {
+        const Instruction& op = instructions[i];
+        const Instruction* const next = (i + 1 < count) ? &instructions[i + 1] : nullptr;
+
+        if (next && op.id == Op::eLoadImm &&
+            (next->id == Op::eSetDelayTimer || next->id == Op::eSkipIfKey || next->id == Op::eSkipIfNotKey))
+        {
+            Instruction fused = *next;
+            fused.y = op.x;
+            fused.nnn = op.nn;
+            fused.id = (next->id == Op::eSetDelayTimer) ? Op::eFusedLoadImmSetDelay : Op::eFusedLoadImmSkipKey;
+            block.fused.push_back(fused);
+            i += 2;
+            continue;
+        }
+
+        if (next && op.id == Op::eLoadIndex && next->id == Op::eAddIndex)
+        {
+            Instruction fused = *next;
+            fused.nnn = op.nnn;
+            fused.id = Op::eFusedLoadIndexAdd;
+            block.fused.push_back(fused);
+            i += 2;
+            continue;
+        }
+
+        // A block ending in a skip over a jump is the test of a loop. The jump is the first
+        // instruction after the block, so the block takes in its bytes to be dropped with them.
+        const uint32_t jumpPC = block.endPC + 1u;
+        if (next && i + 2 == count && jumpPC + 1 < MEM_SIZE &&
+            (op.id == Op::eAddImm || op.id == Op::eLoadDelayTimer) &&
+            (next->id == Op::eSkipIfEqualImm || next->id == Op::eSkipIfNotEqualImm) && next->x == op.x)
+        {
+            const Instruction& jump = sInstructionTable[(mMemory[jumpPC] << 8) | mMemory[jumpPC + 1]];
+            if (jump.id == Op::eJump)
+            {
+                Instruction fused = *next;
+                fused.y = op.nn;
+                fused.nnn = jump.nnn;
+                fused.id = (op.id == Op::eAddImm) ? Op::eFusedAddSkipJump : Op::eFusedDelaySkipJump;
+                block.fused.push_back(fused);
+                block.endPC = (uint16_t)(jumpPC + 1);
+                i += 2;
+                continue;
+            }
+        }
+
+        block.fused.push_back(op);
+        ++i;
+    }
+}
+
+void Chip8::RetireBlock(const uint16_t startPC)
+{
+    Scope<BasicBlock>& block = mBlocks[startPC];
+
+    for (uint32_t page = startPC / BLOCK_PAGE_SIZE; page <= block->endPC / BLOCK_PAGE_SIZE; ++page)
+    {
+        auto& starts = mPageBlocks[page];
+        starts.erase(std::remove(std::begin(starts), std::end(starts), startPC), std::end(starts));
+        if (std::empty(starts))
+            mCodePages.reset(page);
+    }
+
+    mRetiredBlocks.push_back(std::move(block));
+    mCodeModified = true;
+
+    if (mJit)
+        mJit->Invalidate(startPC);
+}
+
+// Drops every cached block that overlaps the written range [address, address + size)
+void Chip8::InvalidateBlocks(const uint16_t address, const uint32_t size)
+{
+    const uint32_t firstPage = address / STATE_PAGE_SIZE;
+    const uint32_t lastPage = (std::min<uint32_t>(address + size, MEM_SIZE) - 1) / STATE_PAGE_SIZE;
+    mWrittenPages |= (~0ull >> (63 - lastPage)) & (~0ull << firstPage);
+
+    InvalidateIdleLoops(address, size);
+
+    if (mAot)
+        mAot->Invalidate(address, size);
+
+    if (mCodePages.none())
+        return;
+
+    const uint32_t end = std::min<uint32_t>(address + size, MEM_SIZE) - 1;
+    for (uint32_t page = address / BLOCK_PAGE_SIZE; page <= end / BLOCK_PAGE_SIZE; ++page)
+    {
+        if (!mCodePages.test(page))
+            continue;
+
+        // Walked backwards since retiring a block erases it from the list
+        const auto& starts = mPageBlocks[page];
+        for (size_t i = std::size(starts); i-- > 0;)
+        {
+            const BasicBlock& block = *mBlocks[starts[i]];
+            if (block.startPC <= end && address <= block.endPC)
+                RetireBlock(block.startPC);
+        }
+    }
+}
+
+void Chip8::InvalidateAllBlocks()
+{
+    mWrittenPages = ~0ull;
+    mIdleLoops.clear();
+
+    for (auto& block : mBlocks)
+    {
+        if (block)
+            mRetiredBlocks.push_back(std::move(block));
+    }
+
+    for (auto& starts : mPageBlocks)
+        starts.clear();
+
+    mCodePages.reset();
+    mCodeModified = true;
+
+    if (mJit)
+        mJit->InvalidateAll();
+
+    if (mAot)
+        mAot->InvalidateAll();
+}
+
+void Chip8::WriteMemory(const uint16_t address, const uint8_t value)
+{
+    mMemory[address] = value;
+    InvalidateBlocks(address, 1);
+}
+
+void Chip8::LoadGame(const std::filesystem::path& game)
+{
+    if (game.extension() != std::filesystem::path(".c8") &&
+        game.extension() != std::filesystem::path(".ch8"))
+    {
+        const std::string error = game.generic_string() + " isn't a .c8 or .ch8 file";
+        LOG_ERROR(error.c_str());
+        throw std::invalid_argument(error);
+    }
+
+    std::ifstream f(game, std::ios_base::in | std::ios_base::binary);
+    if (!f)
+    {
+        const std::string error = "Unable to open game: " + game.generic_string();
+        LOG_ERROR(error.c_str());
+        throw std::invalid_argument(error);
+    }
+
+    const size_t fileSize = std::filesystem::file_size(game);
+    if (fileSize > std::size(mMemory) - 0x200)
+    {
+        const std::string error = "Rom " + game.string() + " is too large to fit in memory";
+        LOG_ERROR(error.c_str());
+        throw std::invalid_argument(error);
+    }
+
+    mAot.reset();
+    mSaveSlots->Close();
+    mInitialState.clear();
+
+    Init();
+
+    f.read((char*)std::data(mMemory) + 0x200, fileSize);
+    mRom.assign(std::data(mMemory) + 0x200, std::data(mMemory) + 0x200 + fileSize);
+    mRomHash = Hash::Fnv1a(std::data(mRom), std::size(mRom));
+
+    mGameFile = game;
+    // Only opened if there are saves already, so running a rom leaves no file behind
+    mSaveSlots->Open(GetSaveSlotsPath(), false);
+
+    const auto library = GetAotLibraryPath(game);
+    if (std::filesystem::exists(library))
+    {
+        mAot = CreateScope<AotModule>(*this);
+        if (!mAot->Load(library, (uint32_t)fileSize))
+            mAot.reset();
+    }
+}
+
+std::string Chip8::Disassemble()
+{
+    if (!std::filesystem::exists(mGameFile))
+        return {};
+
+    const auto fileSize = std::filesystem::file_size(mGameFile);
+    if (fileSize == 0)
+    {
+        LOG_ERROR("File is empty: {0}", mGameFile.string());
+        return {};
+    }
+
+    std::string fileProgram;
+    for (int pc = 0x200; pc < 0x200 + fileSize; pc += 2)
+    {
+        auto opcode = DisassembleOpcode(std::data(mMemory), pc);
+        fileProgram += opcode + '\n';
+    }
+
+    return fileProgram;
+}
+
+const std::vector<uint32_t>& Chip8::GetVramImage()
+{
+    const uint32_t width = GetScreenWidth();
+    const uint32_t height = GetScreenHeight();
+    if (std::size(mVramImage) != width * height)
+    {
+        mVramImage.resize(width * height);
+        mDirtyRows = ~0ull;
+    }
+
+    const uint32_t palette[2] = { mUndrawnColor, mDrawnColor };
+    const uint32_t wordsPerRow = width / 64;
+    for (uint32_t row = 0; row < height && mDirtyRows != 0; ++row)
+    {
+        if ((mDirtyRows & (1ull << row)) == 0)
+            continue;
+
+        uint32_t* pixel = std::data(mVramImage) + row * width;
+        for (uint32_t i = 0; i < wordsPerRow; ++i)
+        {
+            const uint64_t word = mVram[row * wordsPerRow + i];
+            for (int32_t bit = 63; bit >= 0; --bit)
+                *pixel++ = palette[(word >> bit) & 1];
+        }
+
+        mDirtyRows &= ~(1ull << row);
+    }
+
+    mDirtyRows = 0;
+    return mVramImage;
+}
+
+uint8_t Chip8::ReadVram(const uint32_t offset) const
+{
+    return (uint8_t)(mVram[offset / 8] >> (56 - (offset % 8) * 8));
+}
+
+void Chip8::WriteVram(const uint32_t offset, const uint8_t value)
+{
+    const uint32_t shift = 56 - (offset % 8) * 8;
+    uint64_t& word = mVram[offset / 8];
+    word = (word & ~(0xFFull << shift)) | ((uint64_t)value << shift);
+    mDirtyRows |= 1ull << (offset * 8 / GetScreenWidth());
+    mHot.redraw = true;
+}
+
+void Chip8::SetRandomSeed(const uint64_t seed)
+{
+    mRandomSeed = seed;
+
+    // SplitMix64 spreads seeds that are close together, like small numbers or clock readings
+    uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    SetRandomState(z ^ (z >> 31));
+}
+
+void Chip8::SaveState(const uint32_t slot)
+{
+    if (std::empty(mGameFile))
+        return;
+
+    if (slot < 1 || slot > SaveSlotStore::NUM_SLOTS)
+    {
+        LOG_ERROR("There's no save slot {}", slot);
+        return;
+    }
+
+    if (!mSaveSlots->IsOpen() && !mSaveSlots->Open(GetSaveSlotsPath(), true))
+        return;
+
+    PrepareSaveBuffers();
+    WriteState(std::data(mSaveState));
+    SaveStateFile::Pack(std::data(mSaveState), std::data(mInitialState), STATE_SIZE, mRomHash, mSaveFile);
+    if (!mSaveSlots->Write(slot - 1, std::data(mSaveFile), std::size(mSaveFile), mSaveSync))
+    {
+        LOG_ERROR("Save state for slot {} doesn't fit", slot);
+        return;
+    }
+
+    LOG_INFO("Saved State: slot {}", slot);
+}
+
+void Chip8::LoadState(const uint32_t slot)
+{
+    if (std::empty(mGameFile))
+        return;
+
+    size_t size = 0;
+    const uint8_t* const data = (slot >= 1) ? mSaveSlots->Read(slot - 1, size) : nullptr;
+    if (size == 0)
+    {
+        LOG_ERROR("Save slot {} is empty", slot);
+        return;
+    }
+
+    PrepareSaveBuffers();
+    if (!SaveStateFile::Unpack(data, size, std::data(mInitialState), STATE_SIZE, mRomHash, std::data(mSaveState)))
+    {
+        LOG_ERROR("Failed to load save slot {}", slot);
+        return;
+    }
+
+    // The CRC only catches damage, so a state that would run outside memory or the stack is
+    // refused before anything indexes with it
+    HotState hot;
+    memcpy(&hot, std::data(mSaveState), sizeof(HotState));
+    if (hot.sp >= std::size(hot.stack) || hot.pc >= MEM_SIZE - 1 || hot.graphicsMode > GraphicsMode::e128x64)
+    {
+        LOG_ERROR("Save slot {} holds a state the Chip8 can't run", slot);
+        return;
+    }
+    ReadState(std::data(mSaveState));
+
+    LOG_INFO("Loaded State: slot {}", slot);
+}
+
+std::filesystem::path Chip8::GetSaveSlotsPath() const
+{
+    return std::filesystem::path("Resources/SaveStates") / (mGameFile.stem().string() + ".c8slots");
+}
+
+void Chip8::PrepareSaveBuffers()
+{
+    if (!std::empty(mInitialState))
+        return;
+
+    mInitialState.resize(STATE_SIZE);
+    WriteInitialState(std::data(mInitialState));
+    mSaveState.resize(STATE_SIZE);
+    mSaveFile.reserve(SaveSlotStore::MAX_CONTAINER_SIZE);
+}
+
+void Chip8::WriteState(uint8_t* const state, const bool withMemory) const
+{
+    memcpy(state, &mHot, sizeof(HotState));
+    if (withMemory)
+        memcpy(state + STATE_MEMORY_OFFSET, std::data(mMemory), sizeof(uint8_t) * std::size(mMemory));
+    memcpy(state + STATE_MEMORY_OFFSET + MEM_SIZE, std::data(mVram), sizeof(uint64_t) * std::size(mVram));
+}
+
+void Chip8::ReadState(const uint8_t* const state, const bool withMemory)
+{
+    const GraphicsMode graphicsMode = mHot.graphicsMode;
+    memcpy(&mHot, state, sizeof(HotState));
+    SetRandomState(mHot.randomState);
+
+    if (withMemory)
+    {
+        memcpy(std::data(mMemory), state + STATE_MEMORY_OFFSET, sizeof(uint8_t) * std::size(mMemory));
+        InvalidateAllBlocks();
+    }
+
+    // Only the rows that change have to be expanded again
+    Vram vram;
+    memcpy(std::data(vram), state + STATE_MEMORY_OFFSET + MEM_SIZE, sizeof(uint64_t) * std::size(vram));
+    if (mHot.graphicsMode != graphicsMode)
+    {
+        mDirtyRows = ~0ull;
+    }
+    else
+    {
+        const uint32_t wordsPerRow = GetScreenWidth() / 64;
+        const uint32_t numWords = GetScreenHeight() * wordsPerRow;
+        for (uint32_t i = 0; i < numWords; ++i)
+        {
+            if (vram[i] != mVram[i])
+                mDirtyRows |= 1ull << (i / wordsPerRow);
+        }
+    }
+    mVram = vram;
+}
+
+void Chip8::WriteInitialState(uint8_t* const state) const
+{
+    memset(state, 0, STATE_SIZE);
+    uint8_t* const memory = state + STATE_MEMORY_OFFSET;
+    memcpy(memory, std::data(FontSet), std::size(FontSet));
+    if (!std::empty(mRom))
+        memcpy(memory + 0x200, std::data(mRom), std::size(mRom));
+}
+
+uint64_t Chip8::HashHotState() const
+{
+    return Hash::Fnv1a(&mHot, sizeof(HotState));
+}
+
+uint64_t Chip8::HashState() const
+{
+    return Hash::Fnv1a(std::data(mVram), sizeof(Vram), HashHotState());
+}
+
+Chip8::StatePages Chip8::TakeWrittenPages()
+{
+    const StatePages pages = mWrittenPages;
+    mWrittenPages = 0;
+    return pages;
+}
+
+void Chip8::TakeCheckpoint(Checkpoint& checkpoint)
+{
+    checkpoint.state.resize(STATE_SIZE);
+    WriteState(std::data(checkpoint.state));
+    checkpoint.gameFile = mGameFile;
+    checkpoint.frameRate = mFrameRate;
+    checkpoint.cycleClock = mCycleClock;
+    checkpoint.timerClock = mTimerClock;
+    checkpoint.totalCycles = mTotalCycles;
+    checkpoint.idleCycles = mIdleCycles;
+    checkpoint.writtenPages = TakeWrittenPages();
+}
+
+void Chip8::RestoreCheckpoint(const Checkpoint& checkpoint)
+{
+    const StatePages written = TakeWrittenPages();
+    const uint8_t* const memory = std::data(checkpoint.state) + STATE_MEMORY_OFFSET;
+    for (uint32_t page = 0; page < NUM_STATE_PAGES && (written >> page) != 0; ++page)
+    {
+        if (((written >> page) & 1) == 0)
+            continue;
+
+        // A written page often ends up holding what it held before, so only the bytes that
+        // really differ are copied back and have their blocks dropped
+        const uint32_t address = page * STATE_PAGE_SIZE;
+        uint8_t* const current = std::data(mMemory) + address;
+        const uint8_t* const saved = memory + address;
+        if (memcmp(current, saved, STATE_PAGE_SIZE) != 0)
+        {
+            uint32_t start = 0;
+            while (start < STATE_PAGE_SIZE)
+            {
+                if (current[start] == saved[start])
+                {
+                    ++start;
+                    continue;
+                }
+
+                uint32_t end = start + 1;
+                while (end < STATE_PAGE_SIZE && current[end] != saved[end])
+                    ++end;
+
+                memcpy(current + start, saved + start, end - start);
+                InvalidateBlocks((uint16_t)(address + start), end - start);
+                start = end;
+            }
+        }
+
+        // Writes made ahead dropped the recompiled blocks on the page, which hold again now that
+        // it's back to what it was
+        if (mAot)
+            mAot->Revalidate((uint16_t)address, STATE_PAGE_SIZE);
+    }
+
+    ReadState(std::data(checkpoint.state), false);
+    if (mGameFile != checkpoint.gameFile)
+        mGameFile = checkpoint.gameFile;
+    mFrameRate = checkpoint.frameRate;
+    mCycleClock = checkpoint.cycleClock;
+    mTimerClock = checkpoint.timerClock;
+    mTotalCycles = checkpoint.totalCycles;
+    mIdleCycles = checkpoint.idleCycles;
+    // The pages written since are back to what they were, so only the ones before still count
+    mWrittenPages = checkpoint.writtenPages;
+}
+
+uint16_t Chip8::GetScreenWidth() const
+{
+    switch (mHot.graphicsMode)
+    {
+    case GraphicsMode::e64x32:
+        return 64;
+
+    case GraphicsMode::e128x64:
+        return 128;
+    }
+
+    return 64;
+}
+
+uint16_t Chip8::GetScreenHeight() const
+{
+    switch (mHot.graphicsMode)
+    {
+    case GraphicsMode::e64x32:
+        return 32;
+
+    case GraphicsMode::e128x64:
+        return 64;
+    }
+
+    return 32;
+}
+
+void Chip8::ChangeGraphicsMode(const GraphicsMode mode)
+{
+    if (mode == mHot.graphicsMode)
+        return;
+
+    // The rows change size, so the screen starts out clear in the new mode
+    mHot.graphicsMode = mode;
+    mVram.fill(0);
+    mDirtyRows = ~0ull;
+    mHot.redraw = true;
+}
+
+void Chip8::SetDrawnColor(const uint32_t color)
+{
+    if (color == mDrawnColor)
+        return;
+
+    // Every row has to be expanded again in the new colour
+    mDrawnColor = color;
+    mDirtyRows = ~0ull;
+    mHot.redraw = true;
+}
+
+void Chip8::SetUndrawnColor(const uint32_t color)
+{
+    if (color == mUndrawnColor)
+        return;
+
+    mUndrawnColor = color;
+    mDirtyRows = ~0ull;
+    mHot.redraw = true;
+}
+
+void Chip8::CloseGame()
+{
+    mAot.reset();
+    mSaveSlots->Close();
+    mInitialState.clear();
+
+    Init();
+
+    mGameFile = "";
+}
+
+std::string Chip8::DisassembleOpcode(const uint8_t* const buffer, const uint16_t pc)
+{
+    const uint16_t opcode = (buffer[pc] << 8) | buffer[pc + 1];
+
+    char text[32] = {};
+    switch (opcode & 0xF000)
+    {
+    case 0x0000:
+    {
+        switch (opcode)
+        {
+        case 0x00E0: // 0x00E0: Clears the screen
+            return "0x00E0 CLS";
+
+        case 0x00EE: // 0x00EE: Returns from subroutine
+            return "0x00EE RET";
+
+        case 0x00FF: // 0x00FF: Enable 128x64 high res graphics mode
+            return "0x00FF HIGH";
+
+        case 0x00FE: // 0x00FE: Disable 128x64 high res graphics mode
+            return "0x00FE LOW";
+
+        case 0x00FB: // 0x00FB: Scroll the display right by 4 pixels
+            return "0x00FB SCR";
+
+        case 0x00FC: // 0x00FC: Scroll the display left by 4 pixels
+            return "0x00FC SCL";
+
+        case 0x00FD: // 0x00FD Exit the Chip8/SuperChip interpreter
+            return "0x00FD EXIT";
+        }
+
+        // 0x00CN Scroll the display down by 0 to 15 pixels
+        if ((opcode & 0x00F0) == 0x00C0)
+        {
+            snprintf(text, sizeof(text), "0x%04X SCD", opcode);
+            return text;
+        }
+    }
+    break;
+
+    case 0x1000: // 0x1NNN Jump to address NNN
+    {
+        snprintf(text, sizeof(text), "0x%04X JP", opcode);
+        return text;
+    }
+
+    case 0x2000: // 0x2NNN Calls subroutine at NNN
+    {
+        snprintf(text, sizeof(text), "0x%04X CALL", opcode);
+        return text;
+    }
+
+    case 0x3000: // 0x3XNN Skips next instruction if VX equals NN
+    {
+        snprintf(text, sizeof(text), "0x%04X SE", opcode);
+        return text;
+    }
+
+    case 0x4000: // 0x4XNN Skips next instruction if VX does not equal NN
+    {
+        snprintf(text, sizeof(text), "0x%04X SNE", opcode);
+        return text;
+    }
+
+    case 0x5000: // 0x5XY0 Skips next instruction if VX equals VY
+    {
+        snprintf(text, sizeof(text), "0x%04X SE", opcode);
+        return text;
+    }
+
+    case 0x6000: // 0x6XNN Sets VX to NN
+    {
+        snprintf(text, sizeof(text), "0x%04X LD", opcode);
+        return text;
+    }
+
+    case 0x7000: // 0x7XNN Adds NN to VX (Carry flag is not changed)
+    {
+        snprintf(text, sizeof(text), "0x%04X ADD", opcode);
+        return text;
+    }
+
+    case 0x8000:
+    {
+        switch (opcode & 0x000F)
+        {
+        case 0x0000: // 0x8XY0 Set VX to VY
+        {
+            snprintf(text, sizeof(text), "0x%04X LD", opcode);
+            return text;
+        }
+
+        case 0x0001: // 0x8XY1 Set VX to VX or VY
+        {
+            snprintf(text, sizeof(text), "0x%04X OR", opcode);
+            return text;
+        }
+
+        case 0x0002: // 0x8XY2 Set VX to VX and VY
+        {
+            snprintf(text, sizeof(text), "0x%04X AND", opcode);
+            return text;
+        }
+
+        case 0x0003: // 0x8XY3 Set VX to VX xor VY
+        {
+            snprintf(text, sizeof(text), "0x%04X XOR", opcode);
+            return text;
+        }
+
+        case 0x0004: // 0x8XY4 Adds VY to VX. VF is set when there's a carry
+        {
+            snprintf(text, sizeof(text), "0x%04X ADD", opcode);
+            return text;
+        }
+
+        case 0x0005: // 0x8XY5 VY is subtracted from VX. VF is set to 0 if borrow
+        {
+            snprintf(text, sizeof(text), "0x%04X SUB", opcode);
+            return text;
+        }
+
+        case 0x0006: // 0x8XY6 Stores the least significant bit of VX in VF and then shifts VX to the right by 1.
+        {
+            snprintf(text, sizeof(text), "0x%04X SHR", opcode);
+            return text;
+        }
+
+        case 0x0007: // 0x8XY7 Sets VX to VY minus VX. VF is set to 0 when there's a borrow, and 1 when there isn't.
+        {
+            snprintf(text, sizeof(text), "0x%04X SUBN", opcode);
+            return text;
+        }
+
+        case 0x000E: // 0x8XYE Stores the most significant bit of VX in VF and then shifts VX to the left by 1.
+        {
+            snprintf(text, sizeof(text), "0x%04X SHL", opcode);
+            return text;
+        }
+        }
+    }
+    break;
+
+    case 0x9000: // 0x9XY0 Skips the next instruction if VX does not equal VY
+    {
+        snprintf(text, sizeof(text), "0x%04X SNE", opcode);
+        return text;
+    }
+
+    case 0xA000: // 0xANNN Sets I to the address NNN
+    {
+        snprintf(text, sizeof(text), "0x%04X LD", opcode);
+        return text;
+    }
+
+    case 0xB000: // 0xBNNN Jumps to the address NNN plus V0
+    {
+        snprintf(text, sizeof(text), "0x%04X JP", opcode);
+        return text;
+    }
+
+    case 0xC000: // 0xCXNN Sets VX to the result of bitwise and op on a random number and NN
+    {
+        snprintf(text, sizeof(text), "0x%04X RND", opcode);
+        return text;
+    }
+
+    /*
+     * 0xDXYN
+     * Draws a sprite at coordinate (VX, VY) that has a width of 8 pixels and a height of N pixels.
+     * Each row of 8 pixels is read as bit-coded starting from memory location I; I value does not change
+     * after the execution of this instruction. As described above, VF is set to 1 if any screen pixels
+     * are flipped from set to unset when the sprite is drawn, and to 0 if that does not happen
+     */
+    case 0xD000:
+    {
+        snprintf(text, sizeof(text), "0x%04X DRW", opcode);
+        return text;
+    }
+
+    case 0xE000:
+    {
+        switch (opcode & 0x00FF)
+        {
+        case 0x009E: // 0xEX9E Skips the next instruction if the key stored in VX is pressed.
+        {
+            snprintf(text, sizeof(text), "0x%04X SKP", opcode);
+            return text;
+        }
+
+        case 0x00A1: // 0xEXA1 Skips the next instruction if the key stored in VX is not pressed.
+        {
+            snprintf(text, sizeof(text), "0x%04X SKNP", opcode);
+            return text;
+        }
+        }
+    }
+    break;
+
+    case 0xF000:
+    {
+        switch (opcode & 0x00FF)
+        {
+        case 0x0007: // 0xFX07 Sets VX to the value of the delay timer.
+        {
+            snprintf(text, sizeof(text), "0x%04X LD", opcode);
+            return text;
+        }
+
+            /*
+            * 0xFX0A A key press is awaited, and then stored in VX.
+            * (Blocking Operation. All instruction halted until next key event);
+            */
+        case 0x000A:
+        {
+            snprintf(text, sizeof(text), "0x%04X LD", opcode);
+            return text;
+        }
+
+        case 0x0015: // 0xFX15 Sets delay timer to VX.
+        {
+            snprintf(text, sizeof(text), "0x%04X LD", opcode);
+            return text;
+        }
+
+        case 0x0018: // 0xFX18 Sets sound timer to VX.
+        {
+            snprintf(text, sizeof(text), "0x%04X LD", opcode);
+            return text;
+        }
+
+        case 0x001E: // 0xFX1E Adds VX to I
+        {
+            snprintf(text, sizeof(text), "0x%04X ADD", opcode);
+            return text;
+        }
+
+        case 0x0029: // 0xFX29 Sets I to the location of the sprite for the character in VX. Characters 0-F (in hexadecimal) are represented by a 4x5 font.
+        {
+            snprintf(text, sizeof(text), "0x%04X LD", opcode);
+            return text;
+        }
+
+        case 0x0030: // 0xFX30 Set I to a large hex character based on the value of VX.
+        {
+            snprintf(text, sizeof(text), "0x%04X LD", opcode);
+            return text;
+        }
+
+            /*
+             * 0xFX33
+             *
+             * Stores the binary-coded decimal representation of VX, with the most significant of three digits
+             * at the address in I, the middle digit at I plus 1, and the least significant digit at I plus 2.
+             * (In other words, take the decimal representation of VX, place the hundreds digit in memory at
+             * location in I, the tens digit at location I+1, and the ones digit at location I+2.)
+             */
+        case 0x0033:
+        {
+            snprintf(text, sizeof(text), "0x%04X LD", opcode);
+            return text;
+        }
+
+        case 0x0055: // 0xFX55 Stores V0 to VX (including VX) in memory starting at address I
+        {
+            snprintf(text, sizeof(text), "0x%04X LD", opcode);
+            return text;
+        }
+
+        case 0x0065: // 0xFX65 Fills V0 to VX (including VX) with values from memory starting at address I
+        {
+            snprintf(text, sizeof(text), "0x%04X LD", opcode);
+            return text;
+        }
+
+        case 0x0075: // 0xFX75 Save V0-VX to flag registers
+        {
+            snprintf(text, sizeof(text), "0x%04X LD", opcode);
+            return text;
+        }
+
+        case 0x0085: // 0xFX85 Restore V0-VX from flag registers
+        {
+            snprintf(text, sizeof(text), "0x%04X LD", opcode);
+            return text;
+        }
+        }
+    }
+    break;
+    }
+
+    snprintf(text, sizeof(text), "0x%04X UNKNOWN", opcode);
+    return text;
+}
@@ -0,0 +1,702 @@
+#pragma once
+
+#include "Types.h"
+#include "TimeStep.h"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <string>
+#include <bitset>
+#include <filesystem>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+class JitCompiler;
+class AotModule;
+class SaveSlotStore;
+
+class Chip8
+{
+public:
+    static constexpr uint32_t MEM_SIZE = 64 * 1024;
+
+    // The delay and sound timers count down at 60Hz whatever the instruction rate
+    static constexpr uint32_t TIMER_RATE = 60;
+    // 9 instructions per 60Hz frame, around what the original interpreters ran at
+    static constexpr uint32_t DEFAULT_INSTRUCTIONS_PER_SECOND = 540;
+    // Longest time a single Emulate() call catches up on, so a stall like a breakpoint or a
+    // dragged window doesn't turn into a burst of cycles
+    static constexpr float MAX_TIME_STEP = 0.25f;
+    // Share of a frame at the frame rate that turbo mode spends emulating, leaving the rest to
+    // the frontend
+    static constexpr float TURBO_FRAME_BUDGET = 0.75f;
+
+    // VRAM rows are packed into 64-bit words with the leftmost pixel in the top bit, one word
+    // per row in 64x32 and two in 128x64
+    static constexpr uint32_t VRAM_WORDS = 128 / 64 * 64;
+    using Vram = std::array<uint64_t, VRAM_WORDS>;
+
+    // 60Hz frames the profiler keeps the DXYN count of
+    static constexpr uint32_t PROFILE_FRAMES = 240;
+    static constexpr uint32_t MAX_RUN_AHEAD_FRAMES = 6;
+
+    // Memory writes are tracked in pages, one bit each, so a state can be taken without reading
+    // the parts of memory that didn't change
+    static constexpr uint32_t NUM_STATE_PAGES = 64;
+    static constexpr uint32_t STATE_PAGE_SIZE = MEM_SIZE / NUM_STATE_PAGES;
+    using StatePages = uint64_t;
+
+    // Keys are a bitmask with bit n set while key n is down
+    using UpdateInputFunc = std::function<void(uint16_t&)>;
+    using RenderFunc = std::function<void(const std::vector<uint32_t>&)>;
+    using OpcodeLogFunc = std::function<void(const std::string&)>;
+
+    enum class GraphicsMode : uint8_t
+    {
+        e64x32,
+        e128x64
+    };
+
+    // The registers and flags a running game changes, in one block without padding so it copies,
+    // compares and hashes as plain bytes. Everything but the deeper stack entries fits in the
+    // first 64 bytes.
+    struct HotState
+    {
+        // xorshift64* state for CXNN, never zero
+        uint64_t randomState;
+        uint16_t pc;
+        uint16_t opcode;
+        uint16_t indexReg;
+        uint16_t sp;
+        std::array<uint8_t, 16> v;
+        // Bit n set while key n is down
+        uint16_t keys;
+        uint8_t delayTimer;
+        uint8_t soundTimer;
+        GraphicsMode graphicsMode;
+        bool redraw;
+        // Parked on FX0A until a key is pressed
+        bool waitingForKey;
+        uint8_t unused;
+        std::array<uint8_t, 8> rpl;
+        std::array<uint16_t, 16> stack;
+    };
+    static_assert(std::is_trivially_copyable_v<HotState> && std::has_unique_object_representations_v<HotState>,
+        "HotState has to copy and compare as bytes");
+
+    // Save states and rewind share one flat layout: the hot state, then the memory and VRAM
+    static constexpr uint32_t STATE_MEMORY_OFFSET = sizeof(HotState);
+    static constexpr uint32_t STATE_SIZE = STATE_MEMORY_OFFSET + MEM_SIZE + VRAM_WORDS * sizeof(uint64_t);
+
+    enum class Backend
+    {
+        eSwitch,    // Decodes every opcode through a switch each cycle
+        eTable,     // Looks up the predecoded instruction table
+        eBlockCache, // Runs cached basic blocks of predecoded instructions
+        eJit,        // Runs hot blocks as native x86-64 code, interpreting the rest
+        eAot         // Runs blocks recompiled ahead of time by Chip8-Aot, interpreting the rest
+    };
+
+    // How hard a save pushes its slot out to the disk
+    enum class SaveSync
+    {
+        eNone,  // Leaves it to the OS to write the mapped pages back
+        eAsync, // Starts writing the slot back without waiting for it
+        eSync   // Waits until the slot is on the disk
+    };
+
+    // Where a game spends its instructions, counted while profiling is on
+    struct Profile
+    {
+        // Instructions run at each address, MEM_SIZE of them
+        std::vector<uint64_t> pcCounts;
+        // Instructions run per opcode class, by the top nibble of the opcode
+        std::array<uint64_t, 16> classCounts = {};
+        // DXYN instructions in each of the last PROFILE_FRAMES 60Hz frames, a ring with the
+        // next frame going at frameIndex
+        std::array<uint32_t, PROFILE_FRAMES> drawsPerFrame = {};
+        uint32_t frameIndex = 0;
+        uint64_t totalCycles = 0;
+    };
+
+    // The whole machine in memory, clocks included, for frames that are run and then undone
+    struct Checkpoint
+    {
+        std::vector<uint8_t> state;
+        std::filesystem::path gameFile;
+        uint32_t frameRate = 0;
+        uint64_t cycleClock = 0;
+        uint64_t timerClock = 0;
+        uint64_t totalCycles = 0;
+        uint64_t idleCycles = 0;
+        StatePages writtenPages = 0;
+    };
+
+public:
+    Chip8();
+    ~Chip8();
+
+    void LoadGame(const std::filesystem::path& game);
+    bool HasAotModule() const { return mAot != nullptr; }
+    std::string Disassemble();
+    static std::string DisassembleOpcode(const uint8_t* const buffer, const uint16_t pc);
+
+    // Runs the cycles and timer ticks owed for ts seconds of wall clock time. Whatever doesn't
+    // add up to a whole cycle or tick carries over to the next call.
+    void Emulate(const TimeStep ts);
+    // Runs one frame at the frame rate, for headless runs
+    void Emulate();
+    // Runs one frame at the frame rate with the keys held all the way through instead of read
+    // through the update input func, and never in turbo, so the frame only depends on the state
+    // and the keys. Movies are made of these.
+    void EmulateWithKeys(const uint16_t keys);
+    // Runs exactly numCycles instructions, ticking the timers for the time they take at the
+    // instruction rate. Stops at the cycle the game exits. Returns the cycles run.
+    uint32_t Step(const uint32_t numCycles);
+
+    // Slots 1 to SaveSlotStore::NUM_SLOTS, all kept in one memory mapped file per rom that's
+    // opened with the game, so saving and loading only copy to and from the mapping
+    void SaveState(const uint32_t slot = 1);
+    void LoadState(const uint32_t slot = 1);
+    SaveSync GetSaveSync() const { return mSaveSync; }
+    void SetSaveSync(const SaveSync sync) { mSaveSync = sync; }
+
+    // Writes or reads STATE_SIZE bytes. Writing can leave the memory out for callers that copy
+    // just the written pages themselves.
+    void WriteState(uint8_t* const state, const bool withMemory = true) const;
+    void ReadState(const uint8_t* const state, const bool withMemory = true);
+    // The memory pages written since the last call
+    StatePages TakeWrittenPages();
+
+    // The state the current rom starts from as far as the rom goes: the font and the rom in
+    // memory and everything else zero. Save files are packed against it.
+    void WriteInitialState(uint8_t* const state) const;
+    // FNV-1a of the rom, which save files are tied to
+    uint64_t GetRomHash() const { return mRomHash; }
+
+    const HotState& GetHotState() const { return mHot; }
+    // FNV-1a over the hot state, to tell runs apart without comparing all of them
+    uint64_t HashHotState() const;
+    // The hot state and VRAM, cheap enough to take every frame. Memory is left out, since a
+    // game that wrote something different soon shows it in its registers or on the screen.
+    uint64_t HashState() const;
+
+    // Restoring only copies back the memory pages written since the checkpoint was taken, and
+    // only drops the cached blocks on those pages
+    void TakeCheckpoint(Checkpoint& checkpoint);
+    void RestoreCheckpoint(const Checkpoint& checkpoint);
+
+    // Sends the screen to the render func, like the end of a frame that drew
+    void PresentFrame();
+
+    uint32_t GetFrameRate() const { return mFrameRate; }
+    void SetFrameRate(uint32_t fps) { mFrameRate = fps; }
+
+    // CXNN draws from a generator of its own, so runs with the same seed, rom and inputs get
+    // the same numbers. Loading a game starts the sequence over from the seed, which is taken
+    // from the clock unless one is set.
+    uint64_t GetRandomSeed() const { return mRandomSeed; }
+    void SetRandomSeed(const uint64_t seed);
+    // The generator's position in its sequence, kept in save states
+    uint64_t GetRandomState() const { return mHot.randomState; }
+    void SetRandomState(const uint64_t state) { mHot.randomState = state ? state : 1; }
+
+    uint32_t GetInstructionsPerSecond() const { return mInstructionsPerSecond; }
+    void SetInstructionsPerSecond(const uint32_t ips) { mInstructionsPerSecond = std::max(ips, 1u); }
+
+    // Runs as many frames as fit in a share of each host frame instead of keeping to the wall
+    // clock, presenting only the last screen. Timers still tick once per 60th of emulated time.
+    bool GetTurbo() const { return mTurbo; }
+    void SetTurbo(const bool b) { mTurbo = b; }
+
+    // Each Emulate() call also runs this many frames ahead with the keys held now, shows the
+    // screen they end on and then rolls them back, so a key press shows up that many frames
+    // sooner. Games whose reaction to a key takes at least that long look no different.
+    uint32_t GetRunAheadFrames() const { return mRunAheadFrames; }
+    void SetRunAheadFrames(const uint32_t frames) { mRunAheadFrames = std::min(frames, MAX_RUN_AHEAD_FRAMES); }
+
+    // Instructions run since the game was loaded
+    uint64_t GetTotalCycles() const { return mTotalCycles; }
+
+    // Skips the rest of a timer tick when the game is spinning in a loop that can't change
+    // anything before the next tick, like a delay timer poll or a jump to itself. The skipped
+    // cycles still count as run, so the state after a skip is the same as without one. Skips
+    // end at the next input sample, so they never miss a key change.
+    bool GetIdleSkipping() const { return mIdleSkipping; }
+    void SetIdleSkipping(const bool b) { mIdleSkipping = b; }
+    // Instructions skipped in idle loops or parked on FX0A since the game was loaded
+    uint64_t GetIdleCycles() const { return mIdleCycles; }
+
+    // FX0A found no key down. The core stops running instructions until a key is down at an
+    // input sample, while the timers keep ticking.
+    bool IsWaitingForKey() const { return mHot.waitingForKey; }
+
+    // Counts every instruction by address and opcode class. Counting needs every instruction to
+    // go through its handler, so the JIT, AOT code and fused instructions don't run meanwhile.
+    bool GetProfiling() const { return mProfiling; }
+    void SetProfiling(const bool b);
+    const Profile& GetProfile() const { return mProfile; }
+    void ResetProfile();
+
+    void SetUpdateInputFunc(const UpdateInputFunc& func) { mUpdateInputFunc = func; }
+
+    // How many times per timer tick the keys are read through the update input func, at evenly
+    // spread points. Once is what the original interpreters did.
+    uint32_t GetInputSamplesPerTick() const { return mInputSamplesPerTick; }
+    void SetInputSamplesPerTick(const uint32_t samples) { mInputSamplesPerTick = std::max(samples, 1u); }
+
+    void SetRenderFunc(const RenderFunc& func) { mRenderFunc = func; }
+    void SetOpcodeLogFunc(const OpcodeLogFunc& func) { mOpcodeLogFunc = func; }
+
+    // Publishes the screen at most once per Emulate() call instead of after every cycle that drew
+    bool GetCoalesceFrames() const { return mCoalesceFrames; }
+    void SetCoalesceFrames(const bool b) { mCoalesceFrames = b; }
+
+    // Whether the last Emulate() call published a changed screen, and how many changes have been
+    // published so far, so a frontend can skip screens it already has
+    bool HasVramChanged() const { return mVramChanged; }
+    uint64_t GetVramGeneration() const { return mVramGeneration; }
+
+    uint16_t GetScreenWidth() const;
+    uint16_t GetScreenHeight() const;
+
+    GraphicsMode GetGraphicsMode() const { return mHot.graphicsMode; }
+    void SetGraphicsMode(const GraphicsMode mode) { mHot.graphicsMode = mode; }
+    void ChangeGraphicsMode(const GraphicsMode mode);
+
+    const std::filesystem::path& GetGameFile() const { return mGameFile; }
+    const Vram& GetVram() const { return mVram; }
+    // Packed VRAM of the current graphics mode as bytes, leftmost pixels first
+    uint32_t GetVramSize() const { return GetScreenWidth() * GetScreenHeight() / 8; }
+    uint8_t ReadVram(const uint32_t offset) const;
+    void WriteVram(const uint32_t offset, const uint8_t value);
+    const std::array<uint8_t, MEM_SIZE>& GetMemory() const { return mMemory; }
+    uint8_t ReadMemory(const uint16_t address) const { return mMemory[address]; }
+    void WriteMemory(const uint16_t address, const uint8_t value);
+    std::array<uint8_t, 16> GetVReg() const { return mHot.v; }
+    uint16_t GetKeys() const { return mHot.keys; }
+    void SetKeys(const uint16_t keys) { mHot.keys = keys; }
+    bool IsKeyDown(const uint8_t key) const { return (mHot.keys >> (key & 0xF)) & 1; }
+    std::array<uint16_t, 16> GetStack() const { return mHot.stack; }
+
+    // The screen expanded to colours. The buffer is kept between calls and only the rows that
+    // changed since the last call are expanded again.
+    const std::vector<uint32_t>& GetVramImage();
+
+    uint16_t GetOpcode() const { return (mMemory[mHot.pc] << 8) | mMemory[mHot.pc + 1]; }
+    uint16_t GetIndexReg() const { return mHot.indexReg; }
+    uint16_t GetProgramCounter() const { return mHot.pc; }
+    uint16_t GetStackPointer() const { return mHot.sp; }
+
+    uint8_t GetDelayTimer() const { return mHot.delayTimer; }
+    uint8_t GetSoundTimer() const { return mHot.soundTimer; }
+
+    uint8_t GetVX() const { return mHot.v[(mHot.opcode & 0x0F00) >> 8]; }
+    void SetVX(const uint8_t v) { mHot.v[(mHot.opcode & 0x0F00) >> 8] = v; }
+
+    uint8_t GetVY() const { return mHot.v[(mHot.opcode & 0x00F0) >> 4]; }
+    void SetVY(const uint8_t v) { mHot.v[(mHot.opcode & 0x00F0) >> 4] = v; }
+
+    uint8_t GetVF() const { return mHot.v[0xF]; }
+    void SetVF(const uint8_t v) { mHot.v[0xF] = v; }
+
+    uint8_t GetNN() const { return mHot.opcode & 0x00FF; }
+    uint16_t GetAddress() const { return mHot.opcode & 0x0FFF; }
+
+    Backend GetBackend() const { return mBackend; }
+    void SetBackend(const Backend backend) { mBackend = backend; }
+
+    // Checks every run of JIT code against the interpreter
+    bool GetJitLockstep() const { return mJitLockstep; }
+    void SetJitLockstep(const bool b) { mJitLockstep = b; }
+
+    uint8_t GetEmuSpeedModifier() const { return mEmuSpeedModifier; }
+    void SetEmuSpeedModifier(const uint8_t modifier) { mEmuSpeedModifier = modifier; }
+
+    uint32_t GetDrawnColor() const { return mDrawnColor; }
+    void SetDrawnColor(const uint32_t color);
+
+    uint32_t GetUndrawnColor() const { return mUndrawnColor; }
+    void SetUndrawnColor(const uint32_t color);
+
+    bool GetUseVYForShiftQuirk() const { return mUseVYForShiftQuirk; }
+    void SetUseVYForShiftQuirk(const bool b) { mUseVYForShiftQuirk = b; UpdateQuirkProfile(); }
+
+    bool GetUseBXNNQuirk() const { return mUseBXNNQuirk; }
+    void SetUseBXNNQuirk(const bool b) { mUseBXNNQuirk = b; UpdateQuirkProfile(); }
+
+    bool GetUseIndexIncrementAfterStoreLoadQuirk() const { return mUseIndexIncrementAfterStoreLoadQuirk; }
+    void SetUseIndexIncrementAfterStoreLoadQuirk(const bool b) { mUseIndexIncrementAfterStoreLoadQuirk = b; UpdateQuirkProfile(); }
+
+    void CloseGame();
+
+private:
+    friend class JitCompiler;
+    friend class AotModule;
+
+    // Identifies the handler of a decoded instruction
+    enum class Op : uint8_t
+    {
+        eUnknown,
+        eClearScreen,
+        eReturn,
+        eEnableHighRes,
+        eDisableHighRes,
+        eScrollRight,
+        eScrollLeft,
+        eScrollDown,
+        eExit,
+        eJump,
+        eCall,
+        eSkipIfEqualImm,
+        eSkipIfNotEqualImm,
+        eSkipIfEqualReg,
+        eLoadImm,
+        eAddImm,
+        eMove,
+        eOr,
+        eAnd,
+        eXor,
+        eAddReg,
+        eSub,
+        eShiftRight,
+        eSubReverse,
+        eShiftLeft,
+        eSkipIfNotEqualReg,
+        eLoadIndex,
+        eJumpOffset,
+        eRandom,
+        eDraw,
+        eSkipIfKey,
+        eSkipIfNotKey,
+        eLoadDelayTimer,
+        eWaitKey,
+        eSetDelayTimer,
+        eSetSoundTimer,
+        eAddIndex,
+        eLoadFont,
+        eLoadHiResFont,
+        eStoreBcd,
+        eStoreRegs,
+        eLoadRegs,
+        eSaveFlags,
+        eRestoreFlags,
+        eCount,
+
+        // Idioms the block cache runs through a single fused handler, never produced by Decode
+        eFusedLoadImmSetDelay = eCount, // 6XNN FY15
+        eFusedLoadImmSkipKey,           // 6XNN EY9E/EYA1, a key poll
+        eFusedLoadIndexAdd,             // ANNN FX1E
+        eFusedAddSkipJump,              // 7XNN 3XNN/4XNN 1NNN, a counter loop
+        eFusedDelaySkipJump,            // FX07 3XNN/4XNN 1NNN, a delay timer poll
+        eFusedEnd
+    };
+
+    // An opcode decoded ahead of time into its handler id and operands. Packed into 8 bytes so
+    // the 64K entry table stays small.
+    struct Instruction
+    {
+        uint16_t opcode = 0;
+        uint16_t nnn = 0;
+        uint8_t nn = 0;
+        uint8_t x = 0;
+        uint8_t y = 0;
+        Op id = Op::eUnknown;
+
+        uint8_t GetN() const { return opcode & 0x000F; }
+    };
+    static_assert(sizeof(Instruction) == 8, "Instruction should stay packed into 8 bytes");
+
+    using OpHandler = void (Chip8::*)(const Instruction&);
+    using HandlerTable = std::array<OpHandler, (size_t)Op::eCount>;
+    // Fused handlers return the number of instructions they ran, which is one less than their
+    // length when a skip jumps over the trailing 1NNN
+    using FusedHandler = uint32_t (Chip8::*)(const Instruction&);
+    using FusedHandlerTable = std::array<FusedHandler, (size_t)Op::eFusedEnd - (size_t)Op::eCount>;
+    using InstructionTable = std::array<Instruction, 0x10000>;
+
+    // A straight run of instructions that ends at the first one that can change the flow
+    struct BasicBlock
+    {
+        uint16_t startPC = 0;
+        uint16_t endPC = 0;
+        std::vector<Instruction> instructions;
+        // The same instructions with common idioms fused, what the block cache dispatches. A fused
+        // skip and jump can take in the 1NNN right after the block, which endPC then covers.
+        std::vector<Instruction> fused;
+    };
+
+    static constexpr uint64_t NS_PER_SECOND = 1000000000;
+    static constexpr uint32_t TURBO_FRAMES_PER_CLOCK_CHECK = 16;
+
+    // Idle loops are short runs of code ending in a jump back to their start. A loop that keeps
+    // changing registers, like a counter, is given up on after a few tries.
+    static constexpr uint32_t MAX_IDLE_LOOP_BYTES = 16;
+    static constexpr uint8_t MAX_IDLE_LOOP_FAILURES = 16;
+    // What's known about the loop starting at each address
+    static constexpr uint8_t IDLE_LOOP_UNKNOWN = 0;
+    static constexpr uint8_t IDLE_LOOP_NONE = 1;
+    static constexpr uint8_t IDLE_LOOP_CANDIDATE = 2; // Plus the number of failed tries
+
+    static constexpr uint32_t MAX_BLOCK_LENGTH = 64;
+    static constexpr uint32_t BLOCK_PAGE_SIZE = 256;
+    static constexpr uint32_t NUM_BLOCK_PAGES = MEM_SIZE / BLOCK_PAGE_SIZE;
+
+    // Quirk settings as bits of a profile. The interpreter loop and the handlers a quirk changes
+    // are compiled once per profile, so no quirk is tested while running. A new quirk takes a
+    // bit here, a constant in QuirkProfile and an if constexpr in the handlers it changes.
+    static constexpr uint32_t QUIRK_VY_FOR_SHIFT = 1 << 0;
+    static constexpr uint32_t QUIRK_BXNN = 1 << 1;
+    static constexpr uint32_t QUIRK_INDEX_INCREMENT = 1 << 2;
+    // Not a quirk, but compiled in the same way so the profiling counters cost nothing when off
+    static constexpr uint32_t PROFILING = 1 << 3;
+    static constexpr uint32_t NUM_QUIRK_PROFILES = 1 << 4;
+
+    template <uint32_t Flags>
+    struct QuirkProfile
+    {
+        static constexpr bool UseVYForShift = (Flags & QUIRK_VY_FOR_SHIFT) != 0;
+        static constexpr bool UseBXNN = (Flags & QUIRK_BXNN) != 0;
+        static constexpr bool UseIndexIncrementAfterStoreLoad = (Flags & QUIRK_INDEX_INCREMENT) != 0;
+        static constexpr bool Profiling = (Flags & PROFILING) != 0;
+    };
+
+    // The code compiled for one quirk profile
+    struct QuirkProfileFuncs
+    {
+        const HandlerTable* handlers = nullptr;
+        uint32_t (Chip8::*emulateFrame)(const uint32_t numCycles, const uint32_t numTicks) = nullptr;
+        uint32_t (Chip8::*emulateBlock)(const uint32_t maxCycles) = nullptr;
+    };
+
+private:
+    void Init();
+    void UpdateQuirkProfile();
+    uint32_t EmulateFor(const uint64_t ns);
+    void EmulateTurbo();
+    void RunAhead();
+
+    template <typename Quirks> uint32_t EmulateFrame(const uint32_t numCycles, const uint32_t numTicks);
+    template <typename Quirks> uint32_t EmulateCycles(const uint32_t numCycles);
+    template <typename Quirks> void EmulateCycle();
+    template <typename Quirks> uint32_t EmulateBlock(const uint32_t maxCycles);
+    template <typename Quirks> uint32_t EmulateJit(const uint32_t maxCycles);
+    template <typename Quirks> uint32_t EmulateAot(const uint32_t maxCycles);
+    template <typename Quirks> void Execute(const Instruction& op);
+    template <typename Quirks> uint32_t SkipIdleLoop(const uint32_t maxCycles);
+
+    // Runs the block cache or a single handler under the current quirk profile, for code
+    // outside the templated loop
+    uint32_t EmulateBlock(const uint32_t maxCycles) { return (this->*mQuirkProfile->emulateBlock)(maxCycles); }
+    void ExecuteHandler(const Instruction& op) { (this->*(*mQuirkProfile->handlers)[(size_t)op.id])(op); }
+
+    static constexpr Instruction Decode(const uint16_t opcode);
+    static constexpr InstructionTable BuildInstructionTable();
+    template <typename Quirks> static constexpr HandlerTable BuildHandlerTable();
+    template <uint32_t... Flags>
+    static constexpr std::array<QuirkProfileFuncs, sizeof...(Flags)> BuildQuirkProfiles(std::integer_sequence<uint32_t, Flags...>);
+
+    static constexpr bool EndsBlock(const Instruction& op)
+    {
+        return op.id == Op::eJump ||
+            op.id == Op::eCall ||
+            op.id == Op::eReturn ||
+            op.id == Op::eJumpOffset ||
+            op.id == Op::eSkipIfEqualImm ||
+            op.id == Op::eSkipIfNotEqualImm ||
+            op.id == Op::eSkipIfEqualReg ||
+            op.id == Op::eSkipIfNotEqualReg ||
+            op.id == Op::eSkipIfKey ||
+            op.id == Op::eSkipIfNotKey ||
+            op.id == Op::eWaitKey ||
+            op.id == Op::eDraw ||
+            op.id == Op::eExit;
+    }
+
+    static constexpr bool IsFused(const Op id) { return id >= Op::eCount; }
+    static constexpr uint32_t GetFusedLength(const Op id)
+    {
+        return (id == Op::eFusedAddSkipJump || id == Op::eFusedDelaySkipJump) ? 3 : 2;
+    }
+
+    // Whether an instruction always does the same thing while the timers and keys don't change,
+    // without writing memory or VRAM
+    static constexpr bool IsIdleLoopSafe(const Op id)
+    {
+        return id == Op::eJump ||
+            id == Op::eSkipIfEqualImm ||
+            id == Op::eSkipIfNotEqualImm ||
+            id == Op::eSkipIfEqualReg ||
+            id == Op::eSkipIfNotEqualReg ||
+            (id >= Op::eLoadImm && id <= Op::eShiftLeft) ||
+            id == Op::eLoadIndex ||
+            id == Op::eJumpOffset ||
+            id == Op::eSkipIfKey ||
+            id == Op::eSkipIfNotKey ||
+            id == Op::eLoadDelayTimer ||
+            id == Op::eAddIndex ||
+            id == Op::eLoadFont ||
+            id == Op::eLoadHiResFont ||
+            id == Op::eLoadRegs;
+    }
+
+    bool IsIdleLoopCandidate(const uint16_t startPC);
+    void InvalidateIdleLoops(const uint16_t address, const uint32_t size);
+
+    BasicBlock* BuildBlock(const uint16_t startPC);
+    void FuseBlock(BasicBlock& block) const;
+    void RetireBlock(const uint16_t startPC);
+    void InvalidateBlocks(const uint16_t address, const uint32_t size);
+    void InvalidateAllBlocks();
+
+    void OpClearScreen(const Instruction& op);
+    void OpReturn(const Instruction& op);
+    void OpEnableHighRes(const Instruction& op);
+    void OpDisableHighRes(const Instruction& op);
+    void OpScrollRight(const Instruction& op);
+    void OpScrollLeft(const Instruction& op);
+    void OpScrollDown(const Instruction& op);
+    void OpExit(const Instruction& op);
+    void OpJump(const Instruction& op);
+    void OpCall(const Instruction& op);
+    void OpSkipIfEqualImm(const Instruction& op);
+    void OpSkipIfNotEqualImm(const Instruction& op);
+    void OpSkipIfEqualReg(const Instruction& op);
+    void OpLoadImm(const Instruction& op);
+    void OpAddImm(const Instruction& op);
+    void OpMove(const Instruction& op);
+    void OpOr(const Instruction& op);
+    void OpAnd(const Instruction& op);
+    void OpXor(const Instruction& op);
+    void OpAddReg(const Instruction& op);
+    void OpSub(const Instruction& op);
+    template <typename Quirks> void OpShiftRight(const Instruction& op);
+    void OpSubReverse(const Instruction& op);
+    template <typename Quirks> void OpShiftLeft(const Instruction& op);
+    void OpSkipIfNotEqualReg(const Instruction& op);
+    void OpLoadIndex(const Instruction& op);
+    template <typename Quirks> void OpJumpOffset(const Instruction& op);
+    void OpRandom(const Instruction& op);
+    uint8_t NextRandom();
+    void OpDraw(const Instruction& op);
+    void OpSkipIfKey(const Instruction& op);
+    void OpSkipIfNotKey(const Instruction& op);
+    void OpLoadDelayTimer(const Instruction& op);
+    void OpWaitKey(const Instruction& op);
+    void OpSetDelayTimer(const Instruction& op);
+    void OpSetSoundTimer(const Instruction& op);
+    void OpAddIndex(const Instruction& op);
+    void OpLoadFont(const Instruction& op);
+    void OpLoadHiResFont(const Instruction& op);
+    void OpStoreBcd(const Instruction& op);
+    template <typename Quirks> void OpStoreRegs(const Instruction& op);
+    template <typename Quirks> void OpLoadRegs(const Instruction& op);
+    void OpSaveFlags(const Instruction& op);
+    void OpRestoreFlags(const Instruction& op);
+    void OpUnknown(const Instruction& op);
+
+    uint32_t OpFusedLoadImmSetDelay(const Instruction& op);
+    uint32_t OpFusedLoadImmSkipKey(const Instruction& op);
+    uint32_t OpFusedLoadIndexAdd(const Instruction& op);
+    uint32_t OpFusedAddSkipJump(const Instruction& op);
+    uint32_t OpFusedDelaySkipJump(const Instruction& op);
+    uint32_t FinishFusedSkipJump(const Instruction& op);
+
+    void TickTimers();
+
+    std::filesystem::path GetSaveSlotsPath() const;
+    void PrepareSaveBuffers();
+
+private:
+    static const InstructionTable sInstructionTable;
+    template <typename Quirks> static const HandlerTable sHandlerTable;
+    static const FusedHandlerTable sFusedHandlerTable;
+    static const std::array<QuirkProfileFuncs, NUM_QUIRK_PROFILES> sQuirkProfiles;
+
+    // First so it starts the object and its cache line, ahead of the cold members
+    alignas(64) HotState mHot = {};
+
+    UpdateInputFunc mUpdateInputFunc;
+    RenderFunc mRenderFunc;
+    OpcodeLogFunc mOpcodeLogFunc;
+
+    std::filesystem::path mGameFile;
+    std::vector<uint8_t> mRom;
+    uint64_t mRomHash = 0;
+    Scope<SaveSlotStore> mSaveSlots;
+    SaveSync mSaveSync = SaveSync::eAsync;
+    // The initial state of the current rom, made on the first save or load, and the buffers a
+    // save or load goes through
+    std::vector<uint8_t> mInitialState;
+    std::vector<uint8_t> mSaveState;
+    std::vector<uint8_t> mSaveFile;
+
+    std::array<uint8_t, MEM_SIZE> mMemory;
+    Vram mVram;
+    // Rows of VRAM changed since mVramImage was last brought up to date, one bit per row
+    uint64_t mDirtyRows = ~0ull;
+    std::vector<uint32_t> mVramImage;
+
+    // Basic blocks keyed by start PC, and the start PCs of the blocks overlapping each page
+    std::vector<Scope<BasicBlock>> mBlocks;
+    std::array<std::vector<uint16_t>, NUM_BLOCK_PAGES> mPageBlocks;
+    std::bitset<NUM_BLOCK_PAGES> mCodePages;
+    // Invalidated blocks are kept alive until the block that may be running them returns
+    std::vector<Scope<BasicBlock>> mRetiredBlocks;
+    bool mCodeModified = false;
+    StatePages mWrittenPages = ~0ull;
+
+    // One IDLE_LOOP_ value per address, allocated on first use
+    std::vector<uint8_t> mIdleLoops;
+    bool mIdleSkipping = true;
+    uint64_t mIdleCycles = 0;
+
+    Scope<JitCompiler> mJit;
+    bool mJitLockstep = false;
+
+    // Library recompiled from the current rom by Chip8-Aot, if one was found next to it
+    Scope<AotModule> mAot;
+
+    uint32_t mInputSamplesPerTick = 1;
+
+    // The seed CXNN starts from
+    uint64_t mRandomSeed = 0;
+
+    uint8_t mEmuSpeedModifier = 1;
+
+    Backend mBackend = Backend::eTable;
+
+    bool mCoalesceFrames = true;
+    bool mVramChanged = false;
+    uint64_t mVramGeneration = 0;
+
+    bool mUseVYForShiftQuirk = false;
+    bool mUseBXNNQuirk = false;
+    bool mUseIndexIncrementAfterStoreLoadQuirk = false;
+    const QuirkProfileFuncs* mQuirkProfile = nullptr;
+
+    uint32_t mFrameRate;
+
+    // The instruction and timer clocks count nanoseconds times their rate, so whole cycles and
+    // ticks come out of a division and the remainders carry over without drifting
+    uint32_t mInstructionsPerSecond = DEFAULT_INSTRUCTIONS_PER_SECOND;
+    uint64_t mCycleClock = 0;
+    uint64_t mTimerClock = 0;
+    uint64_t mTotalCycles = 0;
+    bool mTurbo = false;
+    uint32_t mRunAheadFrames = 0;
+    Checkpoint mRunAheadCheckpoint;
+    // The screen last presented has drawing from frames run ahead, which isn't in VRAM
+    bool mShowingRunAhead = false;
+    bool mRunningAhead = false;
+
+    bool mProfiling = false;
+    Profile mProfile;
+    uint32_t mProfileFrameDraws = 0;
+
+    // Colors for monochrome screen
+    uint32_t mDrawnColor = 0xFFFFFFFF; // White
+    uint32_t mUndrawnColor = 0xFF000000; // Black
+};
@@ -0,0 +1,86 @@
+#include "HeadlessRunner.h"
+
+#include <algorithm>
+
+HeadlessRunner::HeadlessRunner(Chip8& chip8) :
+    mChip8(chip8)
+{
+    mChip8.SetUpdateInputFunc([this](uint16_t& keys) {
+        keys = mKeys;
+    });
+}
+
+HeadlessRunner::~HeadlessRunner()
+{
+    mChip8.SetUpdateInputFunc(nullptr);
+}
+
+HeadlessRunner::ExitReason HeadlessRunner::RunFor(const uint64_t cycles)
+{
+    return Run(std::nullopt, cycles);
+}
+
+HeadlessRunner::ExitReason HeadlessRunner::RunUntil(const Event event, const uint64_t maxCycles)
+{
+    return Run(event, maxCycles);
+}
+
+void HeadlessRunner::SetInputScript(const std::vector<InputEvent>& script)
+{
+    mScript = script;
+    mNextInput = 0;
+    ApplyInput();
+}
+
+const char* HeadlessRunner::GetExitReasonName(const ExitReason reason)
+{
+    switch (reason)
+    {
+    case ExitReason::eCyclesRun: return "cycles run";
+    case ExitReason::eGameExited: return "game exited";
+    case ExitReason::eBreakpoint: return "breakpoint";
+    case ExitReason::eScreenChanged: return "screen changed";
+    }
+
+    return "unknown";
+}
+
+HeadlessRunner::ExitReason HeadlessRunner::Run(const std::optional<Event> event, const uint64_t maxCycles)
+{
+    // Runs in pieces of about a frame so the screen and game exit checks don't cost much, down
+    // to single cycles while looking for a breakpoint
+    const bool stepping = event == Event::eBreakpoint && mBreakpoint.has_value();
+    const uint64_t frameCycles = std::max<uint64_t>(
+        (uint64_t)mChip8.GetInstructionsPerSecond() * mChip8.GetEmuSpeedModifier() / mChip8.GetFrameRate(), 1);
+
+    const uint64_t endCycle = mCycles + maxCycles;
+    while (mCycles < endCycle)
+    {
+        if (std::empty(mChip8.GetGameFile()))
+            return ExitReason::eGameExited;
+
+        uint64_t numCycles = stepping ? 1 : std::min(frameCycles, endCycle - mCycles);
+        // Stop at the next input change so it lands on the exact cycle
+        if (mNextInput < std::size(mScript))
+            numCycles = std::min(numCycles, mScript[mNextInput].cycle - mCycles);
+
+        mCycles += mChip8.Step((uint32_t)numCycles);
+
+        ApplyInput();
+
+        if (std::empty(mChip8.GetGameFile()))
+            return ExitReason::eGameExited;
+        if (event == Event::eScreenChange && mChip8.HasVramChanged())
+            return ExitReason::eScreenChanged;
+        if (stepping && mChip8.GetProgramCounter() == *mBreakpoint)
+            return ExitReason::eBreakpoint;
+    }
+
+    return ExitReason::eCyclesRun;
+}
+
+void HeadlessRunner::ApplyInput()
+{
+    while (mNextInput < std::size(mScript) && mScript[mNextInput].cycle <= mCycles)
+        mKeys = mScript[mNextInput++].keys;
+}
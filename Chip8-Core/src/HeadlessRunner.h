@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Chip8.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/*
+ * Drives a Chip8 without a window or a clock, for scripted and batch runs.
+ *
+ * Runs are counted in instructions rather than wall clock time, so the same rom, inputs and
+ * settings always end in the same state. Keys come from an input script of timed key states
+ * instead of a keyboard. The runner owns the Chip8's input callback while it's alive.
+ */
+class HeadlessRunner
+{
+public:
+    // What a run stops on besides running out of cycles
+    enum class Event
+    {
+        eGameExit,     // The game ran 00FD
+        eBreakpoint,   // The program counter reached the breakpoint
+        eScreenChange  // A changed screen was published
+    };
+
+    enum class ExitReason
+    {
+        eCyclesRun,
+        eGameExited,
+        eBreakpoint,
+        eScreenChanged
+    };
+
+    // The keys held from the given cycle on, bit n for key n
+    struct InputEvent
+    {
+        uint64_t cycle = 0;
+        uint16_t keys = 0;
+    };
+
+public:
+    HeadlessRunner(Chip8& chip8);
+    ~HeadlessRunner();
+
+    HeadlessRunner(const HeadlessRunner&) = delete;
+    HeadlessRunner& operator=(const HeadlessRunner&) = delete;
+
+    ExitReason RunFor(const uint64_t cycles);
+    // Runs until the event happens or maxCycles have run, whichever comes first. A game exit
+    // always stops the run.
+    ExitReason RunUntil(const Event event, const uint64_t maxCycles);
+
+    // Events have to be in cycle order
+    void SetInputScript(const std::vector<InputEvent>& script);
+
+    void SetBreakpoint(const uint16_t pc) { mBreakpoint = pc; }
+    void ClearBreakpoint() { mBreakpoint.reset(); }
+
+    // Instructions run by this runner. Unlike Chip8::GetTotalCycles() it doesn't start over
+    // when the game exits.
+    uint64_t GetCycles() const { return mCycles; }
+
+    static const char* GetExitReasonName(const ExitReason reason);
+
+private:
+    ExitReason Run(const std::optional<Event> event, const uint64_t maxCycles);
+    void ApplyInput();
+
+private:
+    Chip8& mChip8;
+
+    std::vector<InputEvent> mScript;
+    size_t mNextInput = 0;
+    uint16_t mKeys = 0;
+
+    std::optional<uint16_t> mBreakpoint;
+    uint64_t mCycles = 0;
+};
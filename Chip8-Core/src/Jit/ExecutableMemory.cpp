@@ -0,0 +1,54 @@
+#include "ExecutableMemory.h"
+
+#include "Log.h"
+
+#ifdef _WIN32
+#   include <Windows.h>
+#else
+#   include <sys/mman.h>
+#endif
+
+ExecutableMemory::~ExecutableMemory()
+{
+    Free();
+}
+
+bool ExecutableMemory::Allocate(const size_t size)
+{
+    Free();
+
+#ifdef _WIN32
+    void* data = VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+    if (!data)
+    {
+        LOG_ERROR("Failed to allocate {0} bytes of executable memory", size);
+        return false;
+    }
+#else
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED)
+    {
+        LOG_ERROR("Failed to allocate {0} bytes of executable memory", size);
+        return false;
+    }
+#endif
+
+    mData = (uint8_t*)data;
+    mSize = size;
+    return true;
+}
+
+void ExecutableMemory::Free()
+{
+    if (!mData)
+        return;
+
+#ifdef _WIN32
+    VirtualFree(mData, 0, MEM_RELEASE);
+#else
+    munmap(mData, mSize);
+#endif
+
+    mData = nullptr;
+    mSize = 0;
+}
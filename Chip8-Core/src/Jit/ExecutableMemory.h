@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Types.h"
+
+#include <cstddef>
+
+// A block of memory the JIT can both write machine code into and execute
+class ExecutableMemory
+{
+public:
+    ExecutableMemory() = default;
+    ~ExecutableMemory();
+
+    ExecutableMemory(const ExecutableMemory&) = delete;
+    ExecutableMemory& operator=(const ExecutableMemory&) = delete;
+
+    bool Allocate(const size_t size);
+    void Free();
+
+    uint8_t* GetData() const { return mData; }
+    size_t GetSize() const { return mSize; }
+    bool IsValid() const { return mData != nullptr; }
+
+private:
+    uint8_t* mData = nullptr;
+    size_t mSize = 0;
+};
@@ -0,0 +1,692 @@
+#include "JitCompiler.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    using Reg = X64Emitter::Reg;
+
+    // Host registers V registers can be cached in. rbx holds the Chip8, r15 the cycle budget
+    // and rax, rcx and rdx are scratch.
+    constexpr Reg CacheRegs[] = {
+        X64Emitter::RBP, X64Emitter::RSI, X64Emitter::RDI, X64Emitter::R8, X64Emitter::R9,
+        X64Emitter::R10, X64Emitter::R11, X64Emitter::R12, X64Emitter::R13, X64Emitter::R14
+    };
+
+#ifdef _WIN32
+    constexpr Reg ArgReg0 = X64Emitter::RCX;
+    constexpr Reg ArgReg1 = X64Emitter::RDX;
+    constexpr Reg ArgReg2 = X64Emitter::R8;
+#else
+    constexpr Reg ArgReg0 = X64Emitter::RDI;
+    constexpr Reg ArgReg1 = X64Emitter::RSI;
+    constexpr Reg ArgReg2 = X64Emitter::RDX;
+#endif
+
+    // Callee saved registers pushed by the enter stub, plus the stack space that keeps the
+    // stack 16 byte aligned for helper calls and covers the Win64 shadow space
+    constexpr Reg SavedRegs[] = {
+        X64Emitter::RBX, X64Emitter::RBP, X64Emitter::RSI, X64Emitter::RDI,
+        X64Emitter::R12, X64Emitter::R13, X64Emitter::R14, X64Emitter::R15
+    };
+    constexpr int32_t StackReserve = 40;
+
+    constexpr uint16_t VFMask = 1 << 0xF;
+}
+
+JitCompiler::JitCompiler(Chip8& chip8) :
+    mChip8(chip8)
+{
+    mHostRegs.fill(-1);
+
+    mVOffset = Offset(std::data(chip8.mHot.v));
+    mIndexRegOffset = Offset(&chip8.mHot.indexReg);
+    mPCOffset = Offset(&chip8.mHot.pc);
+    mOpcodeOffset = Offset(&chip8.mHot.opcode);
+    mSPOffset = Offset(&chip8.mHot.sp);
+    mStackOffset = Offset(std::data(chip8.mHot.stack));
+    mDelayTimerOffset = Offset(&chip8.mHot.delayTimer);
+    mCodeModifiedOffset = Offset(&chip8.mCodeModified);
+
+#if defined(_M_X64) || defined(__x86_64__)
+    if (!mCode.Allocate(CODE_SIZE))
+    {
+        LOG_ERROR("JIT unavailable, falling back to the interpreter");
+        return;
+    }
+
+    mEntries.resize(Chip8::MEM_SIZE, NO_ENTRY);
+    mLengths.resize(Chip8::MEM_SIZE, 0);
+    mHeat.resize(Chip8::MEM_SIZE, 0);
+
+    mEmitter = X64Emitter(mCode.GetData(), mCode.GetSize());
+    EmitEnterAndExit();
+    Flush();
+#else
+    LOG_WARN("The JIT only supports x86-64, falling back to the interpreter");
+#endif
+}
+
+uint32_t JitCompiler::Run(const uint32_t maxCycles)
+{
+    if (mFlushPending || mCompiledShiftQuirk != mChip8.mUseVYForShiftQuirk)
+        Flush();
+
+    uint32_t cycles = 0;
+    while (cycles < maxCycles)
+    {
+        const uint32_t entry = GetEntry(mChip8.mHot.pc);
+        const uint32_t budget = maxCycles - cycles;
+        if (entry == NO_ENTRY || mLengths[mChip8.mHot.pc] > budget)
+            break;
+
+        mChip8.mCodeModified = false;
+
+        const uint32_t remaining = mEnter(mCode.GetData() + entry, &mChip8, budget);
+        cycles += budget - remaining;
+
+        if (mFlushPending)
+            Flush();
+    }
+
+    return cycles;
+}
+
+uint32_t JitCompiler::RunLockstep(const uint32_t maxCycles)
+{
+    State before;
+    CaptureState(before);
+
+    const uint32_t cycles = Run(maxCycles);
+    if (cycles == 0)
+        return 0;
+
+    State jitResult;
+    CaptureState(jitResult);
+
+    // Restoring the generator too means both runs see the same random numbers
+    RestoreState(before);
+
+    // Blocks built while the JIT ran may have come from memory that was just rolled back
+    if (jitResult.memory != before.memory)
+        mChip8.InvalidateAllBlocks();
+
+    for (uint32_t done = 0; done < cycles;)
+        done += mChip8.EmulateBlock(cycles - done);
+
+    State interpreterResult;
+    CaptureState(interpreterResult);
+
+    if (!StatesMatch(jitResult, interpreterResult))
+    {
+        LOG_ERROR("JIT lockstep mismatch running {0} cycles from PC {1:X}, JIT PC {2:X}, interpreter PC {3:X}",
+            cycles, before.hot.pc, jitResult.hot.pc, interpreterResult.hot.pc);
+        LOG_ERROR("Switching to the block cache backend");
+        mChip8.SetBackend(Chip8::Backend::eBlockCache);
+    }
+
+    return cycles;
+}
+
+void JitCompiler::Flush()
+{
+    mEmitter.SetPosition(mBlocksStart);
+    std::fill(std::begin(mEntries), std::end(mEntries), NO_ENTRY);
+    std::fill(std::begin(mHeat), std::end(mHeat), 0);
+    mLinks.clear();
+
+    mCompiledShiftQuirk = mChip8.mUseVYForShiftQuirk;
+    mFlushPending = false;
+}
+
+// Emits the stub that enters compiled code from C++ and the one that returns from it
+void JitCompiler::EmitEnterAndExit()
+{
+    mEmitter.SetPosition(0);
+    for (const Reg reg : SavedRegs)
+        mEmitter.Push(reg);
+    mEmitter.Alu64RegImm(X64Emitter::AluSub, X64Emitter::RSP, StackReserve);
+
+    mEmitter.MovRegReg64(X64Emitter::RBX, ArgReg1);
+    mEmitter.MovRegReg32(X64Emitter::R15, ArgReg2);
+    mEmitter.JmpReg(ArgReg0);
+
+    // Compiled code jumps here with the PC stored and returns the unused budget
+    mExitPosition = mEmitter.GetPosition();
+    mEmitter.MovRegReg32(X64Emitter::RAX, X64Emitter::R15);
+    mEmitter.Alu64RegImm(X64Emitter::AluAdd, X64Emitter::RSP, StackReserve);
+    for (size_t i = std::size(SavedRegs); i-- > 0;)
+        mEmitter.Pop(SavedRegs[i]);
+    mEmitter.Ret();
+
+    mBlocksStart = mEmitter.GetPosition();
+    mEnter = (EnterFunc)mEmitter.GetPointer(0);
+}
+
+uint32_t JitCompiler::GetEntry(const uint16_t pc)
+{
+    if (mEntries[pc] != NO_ENTRY)
+        return mEntries[pc];
+
+    // Cold blocks stay on the interpreter
+    if (++mHeat[pc] < HOT_THRESHOLD)
+        return NO_ENTRY;
+
+    return Compile(pc);
+}
+
+uint32_t JitCompiler::Compile(const uint16_t startPC)
+{
+    if (!mEmitter.HasRoom(MAX_BLOCK_CODE_SIZE))
+        Flush();
+
+    const Chip8::BasicBlock* block = mChip8.mBlocks[startPC].get();
+    if (!block)
+        block = mChip8.BuildBlock(startPC);
+
+    const auto& instructions = block->instructions;
+    const uint32_t length = std::min((uint32_t)std::size(instructions), MAX_COMPILED_BLOCK_LENGTH);
+    if (length == 0)
+        return NO_ENTRY;
+
+    // VF only needs computing if something reads it before it's written again
+    std::array<bool, MAX_COMPILED_BLOCK_LENGTH> vfLive = {};
+    bool live = true;
+    for (uint32_t i = length; i-- > 0;)
+    {
+        vfLive[i] = live;
+
+        uint16_t reads = 0;
+        uint16_t writes = 0;
+        if (!GetRegisterUse(instructions[i], reads, writes) || Chip8::EndsBlock(instructions[i]))
+            live = true;
+        else
+            live = ((reads & VFMask) != 0) || (live && (writes & VFMask) == 0);
+    }
+
+    mBlockStartPC = startPC;
+    mBlockEntry = mEmitter.GetPosition();
+
+    // Leave the block to the interpreter if the budget can't cover all of it
+    mEmitter.Alu32RegImm(X64Emitter::AluCmp, X64Emitter::R15, length);
+    const size_t bail = mEmitter.JccForward(X64Emitter::CondB);
+    mEmitter.Alu32RegImm(X64Emitter::AluSub, X64Emitter::R15, length);
+
+    AllocateRegisters(instructions, length);
+    LoadCachedRegisters();
+
+    uint16_t pc = startPC;
+    for (uint32_t i = 0; i < length; ++i, pc += 2)
+        EmitInstruction(instructions[i], pc, vfLive[i], length - i - 1);
+
+    // Blocks cut off by the length limits fall through into the next one
+    const Chip8::Instruction& last = instructions[length - 1];
+    if (!Chip8::EndsBlock(last))
+    {
+        EmitBlockExit(last.opcode);
+        EmitLink(pc);
+    }
+
+    mEmitter.BindHere(bail);
+    mEmitter.MovMemImm16(mPCOffset, startPC);
+    mEmitter.Jmp(mExitPosition);
+
+    mEntries[startPC] = (uint32_t)mBlockEntry;
+    mLengths[startPC] = (uint8_t)length;
+    if (const auto it = mLinks.find(startPC); it != std::end(mLinks))
+    {
+        for (const size_t link : it->second)
+            mEmitter.PatchRel32(link, mBlockEntry);
+    }
+
+    return mEntries[startPC];
+}
+
+void JitCompiler::Invalidate(const uint16_t startPC)
+{
+    if (mEntries[startPC] == NO_ENTRY)
+        return;
+
+    // The code itself stays put until the next flush since it may be running right now
+    mEntries[startPC] = NO_ENTRY;
+    mHeat[startPC] = 0;
+    if (const auto it = mLinks.find(startPC); it != std::end(mLinks))
+    {
+        for (const size_t link : it->second)
+            mEmitter.PatchRel32(link, link + 4);
+    }
+}
+
+// Returns true if the instruction has a native translation, along with the V registers it reads and writes
+bool JitCompiler::GetRegisterUse(const Chip8::Instruction& op, uint16_t& reads, uint16_t& writes) const
+{
+    const uint16_t x = 1 << op.x;
+    const uint16_t y = 1 << op.y;
+    const Chip8::Op id = op.id;
+    reads = 0;
+    writes = 0;
+
+    if (id == Chip8::Op::eLoadImm || id == Chip8::Op::eLoadDelayTimer)
+    {
+        writes = x;
+    }
+    else if (id == Chip8::Op::eAddImm)
+    {
+        reads = x;
+        writes = x;
+    }
+    else if (id == Chip8::Op::eMove)
+    {
+        reads = y;
+        writes = x;
+    }
+    else if (id == Chip8::Op::eOr || id == Chip8::Op::eAnd || id == Chip8::Op::eXor)
+    {
+        reads = x | y;
+        writes = x;
+    }
+    else if (id == Chip8::Op::eAddReg || id == Chip8::Op::eSub || id == Chip8::Op::eSubReverse)
+    {
+        // The handlers set VF before using the operands, which only matters when one of them is VF
+        if (op.x == 0xF || op.y == 0xF)
+            return false;
+        reads = x | y;
+        writes = x | VFMask;
+    }
+    else if (id == Chip8::Op::eShiftRight || id == Chip8::Op::eShiftLeft)
+    {
+        if (op.x == 0xF)
+            return false;
+        reads = mCompiledShiftQuirk ? y : x;
+        writes = x | VFMask;
+    }
+    else if (id == Chip8::Op::eAddIndex)
+    {
+        if (op.x == 0xF)
+            return false;
+        reads = x;
+        writes = VFMask;
+    }
+    else if (id == Chip8::Op::eSkipIfEqualImm || id == Chip8::Op::eSkipIfNotEqualImm ||
+        id == Chip8::Op::eLoadFont || id == Chip8::Op::eLoadHiResFont ||
+        id == Chip8::Op::eSetDelayTimer)
+    {
+        reads = x;
+    }
+    else if (id == Chip8::Op::eSkipIfEqualReg || id == Chip8::Op::eSkipIfNotEqualReg)
+    {
+        reads = x | y;
+    }
+    else if (id != Chip8::Op::eLoadIndex && id != Chip8::Op::eJump &&
+        id != Chip8::Op::eCall && id != Chip8::Op::eReturn && id != Chip8::Op::eUnknown)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+// Caches the V registers the block's native code touches more than once
+void JitCompiler::AllocateRegisters(const std::vector<Chip8::Instruction>& instructions, const uint32_t length)
+{
+    std::array<uint32_t, 16> uses = {};
+    for (uint32_t i = 0; i < length; ++i)
+    {
+        uint16_t reads = 0;
+        uint16_t writes = 0;
+        if (!GetRegisterUse(instructions[i], reads, writes))
+            continue;
+
+        for (uint8_t i = 0; i < std::size(uses); ++i)
+        {
+            if ((reads | writes) & (1 << i))
+                ++uses[i];
+        }
+    }
+
+    std::array<uint8_t, 16> order;
+    for (uint8_t i = 0; i < std::size(order); ++i)
+        order[i] = i;
+    std::stable_sort(std::begin(order), std::end(order), [&uses](uint8_t a, uint8_t b) {
+        return uses[a] > uses[b];
+    });
+
+    mHostRegs.fill(-1);
+    mDirtyRegs = 0;
+    for (size_t i = 0; i < std::size(CacheRegs) && uses[order[i]] >= 2; ++i)
+        mHostRegs[order[i]] = (int8_t)CacheRegs[i];
+}
+
+void JitCompiler::EmitInstruction(const Chip8::Instruction& op, const uint16_t pc, const bool vfLive, const uint32_t cyclesLeft)
+{
+    uint16_t reads = 0;
+    uint16_t writes = 0;
+    if (!GetRegisterUse(op, reads, writes))
+    {
+        EmitHelperCall(op, pc, cyclesLeft);
+        return;
+    }
+
+    X64Emitter& e = mEmitter;
+    const Chip8::Op id = op.id;
+    const uint16_t next = pc + 2;
+
+    if (id == Chip8::Op::eLoadImm) // 0x6XNN
+    {
+        if (mHostRegs[op.x] >= 0)
+        {
+            e.MovReg8Imm8((Reg)mHostRegs[op.x], op.nn);
+            mDirtyRegs |= 1 << op.x;
+        }
+        else
+        {
+            e.MovMemImm8(mVOffset + op.x, op.nn);
+        }
+    }
+    else if (id == Chip8::Op::eAddImm) // 0x7XNN
+    {
+        if (mHostRegs[op.x] >= 0)
+        {
+            e.Alu8RegImm(X64Emitter::AluAdd, (Reg)mHostRegs[op.x], op.nn);
+            mDirtyRegs |= 1 << op.x;
+        }
+        else
+        {
+            e.Alu8MemImm(X64Emitter::AluAdd, mVOffset + op.x, op.nn);
+        }
+    }
+    else if (id == Chip8::Op::eMove) // 0x8XY0
+    {
+        WriteV(op.x, ReadV(op.y, X64Emitter::RAX));
+    }
+    else if (id == Chip8::Op::eOr || id == Chip8::Op::eAnd || id == Chip8::Op::eXor) // 0x8XY1-0x8XY3
+    {
+        const X64Emitter::AluOp aluOp = (id == Chip8::Op::eOr) ? X64Emitter::AluOr :
+            (id == Chip8::Op::eAnd) ? X64Emitter::AluAnd : X64Emitter::AluXor;
+        const Reg vx = ReadV(op.x, X64Emitter::RAX);
+        e.Alu8RegReg(aluOp, vx, ReadV(op.y, X64Emitter::RCX));
+        WriteV(op.x, vx);
+    }
+    else if (id == Chip8::Op::eAddReg || id == Chip8::Op::eSub) // 0x8XY4, 0x8XY5
+    {
+        const bool add = id == Chip8::Op::eAddReg;
+        const Reg vx = ReadV(op.x, X64Emitter::RAX);
+        e.Alu8RegReg(add ? X64Emitter::AluAdd : X64Emitter::AluSub, vx, ReadV(op.y, X64Emitter::RCX));
+        // Carry for VX + VY > 0xFF, above for VX > VY
+        if (vfLive)
+            SetVF(add ? X64Emitter::CondB : X64Emitter::CondA);
+        WriteV(op.x, vx);
+    }
+    else if (id == Chip8::Op::eSubReverse) // 0x8XY7
+    {
+        const Reg vx = ReadV(op.x, X64Emitter::RCX);
+        const Reg vy = ReadV(op.y, X64Emitter::RAX);
+        e.MovReg8Reg8(X64Emitter::RDX, vy);
+        e.Alu8RegReg(X64Emitter::AluSub, X64Emitter::RDX, vx);
+        if (vfLive)
+            SetVF(X64Emitter::CondA);
+        WriteV(op.x, X64Emitter::RDX);
+    }
+    else if (id == Chip8::Op::eShiftRight || id == Chip8::Op::eShiftLeft) // 0x8XY6, 0x8XYE
+    {
+        const Reg src = ReadV(mCompiledShiftQuirk ? op.y : op.x, X64Emitter::RAX);
+        const Reg vx = (mHostRegs[op.x] >= 0) ? (Reg)mHostRegs[op.x] : X64Emitter::RAX;
+        if (src != vx)
+            e.MovReg8Reg8(vx, src);
+
+        // The bit shifted out lands in the carry flag
+        e.Shift8Reg((id == Chip8::Op::eShiftRight) ? X64Emitter::ShiftRight : X64Emitter::ShiftLeft, vx);
+        if (vfLive)
+            SetVF(X64Emitter::CondB);
+        WriteV(op.x, vx);
+    }
+    else if (id == Chip8::Op::eLoadIndex) // 0xANNN
+    {
+        e.MovMemImm16(mIndexRegOffset, op.nnn);
+    }
+    else if (id == Chip8::Op::eAddIndex) // 0xFX1E
+    {
+        e.MovzxRegMem16(X64Emitter::RAX, mIndexRegOffset);
+        e.MovzxRegReg8(X64Emitter::RCX, ReadV(op.x, X64Emitter::RCX));
+        e.Alu32RegReg(X64Emitter::AluAdd, X64Emitter::RAX, X64Emitter::RCX);
+        if (vfLive)
+        {
+            e.Alu32RegImm(X64Emitter::AluCmp, X64Emitter::RAX, 0x0FFF);
+            SetVF(X64Emitter::CondA);
+        }
+        e.MovMemReg16(mIndexRegOffset, X64Emitter::RAX);
+    }
+    else if (id == Chip8::Op::eLoadFont || id == Chip8::Op::eLoadHiResFont) // 0xFX29, 0xFX30
+    {
+        const bool hiRes = id == Chip8::Op::eLoadHiResFont;
+        e.MovzxRegReg8(X64Emitter::RAX, ReadV(op.x, X64Emitter::RAX));
+        e.ImulRegRegImm8(X64Emitter::RAX, X64Emitter::RAX, hiRes ? 10 : 5);
+        if (hiRes)
+            e.Alu32RegImm(X64Emitter::AluAdd, X64Emitter::RAX, 80);
+        e.MovMemReg16(mIndexRegOffset, X64Emitter::RAX);
+    }
+    else if (id == Chip8::Op::eLoadDelayTimer) // 0xFX07
+    {
+        e.MovzxRegMem8(X64Emitter::RAX, mDelayTimerOffset);
+        WriteV(op.x, X64Emitter::RAX);
+    }
+    else if (id == Chip8::Op::eSetDelayTimer) // 0xFX15
+    {
+        e.MovMemReg8(mDelayTimerOffset, ReadV(op.x, X64Emitter::RAX));
+    }
+    else if (id == Chip8::Op::eUnknown)
+    {
+        // Only logs, and compiled code never runs while the opcode log is hooked up
+    }
+    else if (id == Chip8::Op::eJump) // 0x1NNN
+    {
+        EmitBlockExit(op.opcode);
+        EmitLink(op.nnn);
+        return;
+    }
+    else if (id == Chip8::Op::eCall) // 0x2NNN
+    {
+        e.MovzxRegMem16(X64Emitter::RAX, mSPOffset);
+        e.Alu32RegImm(X64Emitter::AluAnd, X64Emitter::RAX, 0xF);
+        e.MovRegImm32(X64Emitter::RCX, next);
+        e.MovMemReg16Indexed(mStackOffset, X64Emitter::RAX, X64Emitter::RCX);
+        e.Alu32RegImm(X64Emitter::AluAdd, X64Emitter::RAX, 1);
+        e.Alu32RegImm(X64Emitter::AluAnd, X64Emitter::RAX, 0xF);
+        e.MovMemReg16(mSPOffset, X64Emitter::RAX);
+
+        EmitBlockExit(op.opcode);
+        EmitLink(op.nnn);
+        return;
+    }
+    else if (id == Chip8::Op::eReturn) // 0x00EE
+    {
+        e.MovzxRegMem16(X64Emitter::RAX, mSPOffset);
+        e.Alu32RegImm(X64Emitter::AluSub, X64Emitter::RAX, 1);
+        e.Alu32RegImm(X64Emitter::AluAnd, X64Emitter::RAX, 0xF);
+        e.MovMemReg16(mSPOffset, X64Emitter::RAX);
+        e.MovzxRegMem16Indexed(X64Emitter::RCX, mStackOffset, X64Emitter::RAX);
+        e.MovMemReg16(mPCOffset, X64Emitter::RCX);
+
+        EmitBlockExit(op.opcode);
+        e.Jmp(mExitPosition);
+        return;
+    }
+    else // 0x3XNN, 0x4XNN, 0x5XY0, 0x9XY0
+    {
+        EmitBlockExit(op.opcode);
+
+        // Registers were written back, so the operands are read from memory
+        e.MovzxRegMem8(X64Emitter::RAX, mVOffset + op.x);
+        if (id == Chip8::Op::eSkipIfEqualImm || id == Chip8::Op::eSkipIfNotEqualImm)
+        {
+            e.Alu8RegImm(X64Emitter::AluCmp, X64Emitter::RAX, op.nn);
+        }
+        else
+        {
+            e.MovzxRegMem8(X64Emitter::RCX, mVOffset + op.y);
+            e.Alu8RegReg(X64Emitter::AluCmp, X64Emitter::RAX, X64Emitter::RCX);
+        }
+
+        const bool skipIfEqual = id == Chip8::Op::eSkipIfEqualImm || id == Chip8::Op::eSkipIfEqualReg;
+        const size_t skip = e.JccForward(skipIfEqual ? X64Emitter::CondE : X64Emitter::CondNE);
+        EmitLink(next);
+        e.BindHere(skip);
+        EmitLink(next + 2);
+        return;
+    }
+}
+
+// Runs an instruction through its interpreter handler
+void JitCompiler::EmitHelperCall(const Chip8::Instruction& op, const uint16_t pc, const uint32_t cyclesLeft)
+{
+    X64Emitter& e = mEmitter;
+    const Chip8::Op id = op.id;
+    const uint16_t next = pc + 2;
+
+    WriteBackDirtyRegisters();
+
+    e.MovMemImm16(mPCOffset, next);
+    e.MovMemImm16(mOpcodeOffset, op.opcode);
+    e.MovRegReg64(ArgReg0, X64Emitter::RBX);
+    e.MovRegImm64(ArgReg1, (uint64_t)&Chip8::sInstructionTable[op.opcode]);
+    e.MovRegImm64(X64Emitter::RAX, (uint64_t)&JitCompiler::ExecuteHandler);
+    e.CallReg(X64Emitter::RAX);
+
+    LoadCachedRegisters();
+
+    if (id == Chip8::Op::eStoreBcd || id == Chip8::Op::eStoreRegs)
+    {
+        // Stop right away if the store overwrote compiled code, giving back the unused budget
+        e.Alu8MemImm(X64Emitter::AluCmp, mCodeModifiedOffset, 0);
+        const size_t unmodified = e.JccForward(X64Emitter::CondE);
+        if (cyclesLeft > 0)
+            e.Alu32RegImm(X64Emitter::AluAdd, X64Emitter::R15, cyclesLeft);
+        e.Jmp(mExitPosition);
+        e.BindHere(unmodified);
+    }
+    else if (id == Chip8::Op::eDraw)
+    {
+        EmitBlockExit(op.opcode);
+        EmitLink(next);
+    }
+    else if (Chip8::EndsBlock(op))
+    {
+        // The handler left the PC wherever it goes next
+        EmitBlockExit(op.opcode);
+        e.Jmp(mExitPosition);
+    }
+}
+
+Reg JitCompiler::ReadV(const uint8_t x, const Reg scratch)
+{
+    if (mHostRegs[x] >= 0)
+        return (Reg)mHostRegs[x];
+
+    mEmitter.MovzxRegMem8(scratch, mVOffset + x);
+    return scratch;
+}
+
+void JitCompiler::WriteV(const uint8_t x, const Reg src)
+{
+    if (mHostRegs[x] >= 0)
+    {
+        if (src != mHostRegs[x])
+            mEmitter.MovReg8Reg8((Reg)mHostRegs[x], src);
+        mDirtyRegs |= 1 << x;
+    }
+    else
+    {
+        mEmitter.MovMemReg8(mVOffset + x, src);
+    }
+}
+
+void JitCompiler::SetVF(const X64Emitter::Cond cond)
+{
+    if (mHostRegs[0xF] >= 0)
+    {
+        mEmitter.SetccReg(cond, (Reg)mHostRegs[0xF]);
+        mDirtyRegs |= VFMask;
+    }
+    else
+    {
+        mEmitter.SetccMem(cond, mVOffset + 0xF);
+    }
+}
+
+void JitCompiler::LoadCachedRegisters()
+{
+    for (uint8_t i = 0; i < std::size(mHostRegs); ++i)
+    {
+        if (mHostRegs[i] >= 0)
+            mEmitter.MovzxRegMem8((Reg)mHostRegs[i], mVOffset + i);
+    }
+    mDirtyRegs = 0;
+}
+
+void JitCompiler::WriteBackDirtyRegisters()
+{
+    for (uint8_t i = 0; i < std::size(mHostRegs); ++i)
+    {
+        if (mDirtyRegs & (1 << i))
+            mEmitter.MovMemReg8(mVOffset + i, (Reg)mHostRegs[i]);
+    }
+    mDirtyRegs = 0;
+}
+
+// Leaves the emulator state exactly as the interpreter would have after the block's last instruction
+void JitCompiler::EmitBlockExit(const uint16_t opcode)
+{
+    WriteBackDirtyRegisters();
+    mEmitter.MovMemImm16(mOpcodeOffset, opcode);
+}
+
+// Jumps to the compiled block at the target, or to a stub returning there while it isn't compiled
+void JitCompiler::EmitLink(const uint16_t target)
+{
+    const size_t link = mEmitter.JmpForward();
+    mLinks[target].push_back(link);
+    mEmitter.MovMemImm16(mPCOffset, target);
+    mEmitter.Jmp(mExitPosition);
+
+    if (target == mBlockStartPC)
+        mEmitter.PatchRel32(link, mBlockEntry);
+    else if (mEntries[target] != NO_ENTRY)
+        mEmitter.PatchRel32(link, mEntries[target]);
+}
+
+int32_t JitCompiler::Offset(const void* member) const
+{
+    return (int32_t)((const uint8_t*)member - (const uint8_t*)&mChip8);
+}
+
+void JitCompiler::CaptureState(State& state) const
+{
+    state.hot = mChip8.mHot;
+    state.memory = mChip8.mMemory;
+    state.vram = mChip8.mVram;
+    state.gameFile = mChip8.mGameFile;
+}
+
+void JitCompiler::RestoreState(const State& state)
+{
+    mChip8.mHot = state.hot;
+    mChip8.mMemory = state.memory;
+    mChip8.mVram = state.vram;
+    mChip8.mDirtyRows = ~0ull;
+    mChip8.mGameFile = state.gameFile;
+}
+
+bool JitCompiler::StatesMatch(const State& a, const State& b)
+{
+    return memcmp(&a.hot, &b.hot, sizeof(Chip8::HotState)) == 0 && a.memory == b.memory &&
+        a.vram == b.vram && a.gameFile == b.gameFile;
+}
+
+// Called from compiled code
+void JitCompiler::ExecuteHandler(Chip8* chip8, const Chip8::Instruction* op)
+{
+    chip8->ExecuteHandler(*op);
+}
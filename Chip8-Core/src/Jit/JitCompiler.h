@@ -0,0 +1,131 @@
+#pragma once
+
+#include "Chip8.h"
+#include "Jit/ExecutableMemory.h"
+#include "Jit/X64Emitter.h"
+
+#include <array>
+#include <vector>
+#include <unordered_map>
+
+/*
+ * Translates hot basic blocks into x86-64 code.
+ *
+ * Compiled code runs with rbx pointing at the Chip8 and the remaining cycle budget in r15d.
+ * The V registers used most by a block live in host registers for the whole block and VF is
+ * only computed where a later instruction or the block exit can observe it. Anything without
+ * a native translation is handed to the interpreter handler in place. Blocks ending in a
+ * static jump, call, skip or draw jump straight into the next compiled block, and every block
+ * checks the budget on entry so a frame never runs more cycles than the interpreter would.
+ */
+class JitCompiler
+{
+public:
+    JitCompiler(Chip8& chip8);
+
+    bool IsAvailable() const { return mCode.IsValid(); }
+
+    // Runs compiled code from the PC. Returns the number of instructions executed, which is 0
+    // when the block at the PC is still cold or longer than the budget.
+    uint32_t Run(const uint32_t maxCycles);
+
+    // Runs compiled code, then replays the same cycles on the interpreter and compares the
+    // results. On a mismatch the interpreter's state is kept and the Chip8 falls back to the
+    // block cache backend.
+    uint32_t RunLockstep(const uint32_t maxCycles);
+
+    // Drops the compiled block starting at the PC, unlinking every jump into it
+    void Invalidate(const uint16_t startPC);
+    // Drops all compiled code before the next run
+    void InvalidateAll() { mFlushPending = true; }
+
+private:
+    using EnterFunc = uint32_t (*)(const uint8_t* entry, Chip8* chip8, uint32_t budget);
+
+    // Everything an instruction can change, used to compare the JIT against the interpreter
+    struct State
+    {
+        Chip8::HotState hot;
+        std::array<uint8_t, Chip8::MEM_SIZE> memory;
+        Chip8::Vram vram;
+        std::filesystem::path gameFile;
+    };
+
+    static constexpr size_t CODE_SIZE = 1024 * 1024;
+    // Enough room for the largest block the compiler can emit
+    static constexpr size_t MAX_BLOCK_CODE_SIZE = 8 * 1024;
+    // A frame runs 9 cycles at the default speed and a block only runs if the budget covers
+    // all of it, so longer blocks are split into pieces that chain into each other
+    static constexpr uint32_t MAX_COMPILED_BLOCK_LENGTH = 8;
+    // Times a block has to be dispatched before it is compiled
+    static constexpr uint8_t HOT_THRESHOLD = 16;
+    static constexpr uint32_t NO_ENTRY = 0;
+
+private:
+    void Flush();
+    void EmitEnterAndExit();
+
+    uint32_t GetEntry(const uint16_t pc);
+    uint32_t Compile(const uint16_t startPC);
+
+    bool GetRegisterUse(const Chip8::Instruction& op, uint16_t& reads, uint16_t& writes) const;
+    void AllocateRegisters(const std::vector<Chip8::Instruction>& instructions, const uint32_t length);
+
+    void EmitInstruction(const Chip8::Instruction& op, const uint16_t pc, const bool vfLive, const uint32_t cyclesLeft);
+    void EmitHelperCall(const Chip8::Instruction& op, const uint16_t pc, const uint32_t cyclesLeft);
+
+    X64Emitter::Reg ReadV(const uint8_t x, const X64Emitter::Reg scratch);
+    void WriteV(const uint8_t x, const X64Emitter::Reg src);
+    void SetVF(const X64Emitter::Cond cond);
+    void LoadCachedRegisters();
+    void WriteBackDirtyRegisters();
+
+    void EmitBlockExit(const uint16_t opcode);
+    void EmitLink(const uint16_t target);
+
+    int32_t Offset(const void* member) const;
+
+    void CaptureState(State& state) const;
+    void RestoreState(const State& state);
+    static bool StatesMatch(const State& a, const State& b);
+
+    static void ExecuteHandler(Chip8* chip8, const Chip8::Instruction* op);
+
+private:
+    Chip8& mChip8;
+
+    ExecutableMemory mCode;
+    X64Emitter mEmitter;
+    EnterFunc mEnter = nullptr;
+    size_t mExitPosition = 0;
+    size_t mBlocksStart = 0;
+
+    // Code offsets and lengths of compiled blocks keyed by start PC, and how often cold blocks
+    // were dispatched
+    std::vector<uint32_t> mEntries;
+    std::vector<uint8_t> mLengths;
+    std::vector<uint8_t> mHeat;
+    // Every linking jump by target PC. Each one is followed by a stub that returns to the
+    // dispatcher, which the jump points at while the target isn't compiled.
+    std::unordered_map<uint16_t, std::vector<size_t>> mLinks;
+
+    bool mFlushPending = false;
+    // Quirks that change the generated code rather than the handlers it calls
+    bool mCompiledShiftQuirk = false;
+
+    // Per block compilation state
+    uint16_t mBlockStartPC = 0;
+    size_t mBlockEntry = 0;
+    std::array<int8_t, 16> mHostRegs;
+    uint16_t mDirtyRegs = 0;
+
+    // Chip8 member offsets from the base pointer held in rbx
+    int32_t mVOffset = 0;
+    int32_t mIndexRegOffset = 0;
+    int32_t mPCOffset = 0;
+    int32_t mOpcodeOffset = 0;
+    int32_t mSPOffset = 0;
+    int32_t mStackOffset = 0;
+    int32_t mDelayTimerOffset = 0;
+    int32_t mCodeModifiedOffset = 0;
+};
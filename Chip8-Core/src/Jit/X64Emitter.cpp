@@ -0,0 +1,327 @@
+#include "X64Emitter.h"
+
+#include "Log.h"
+
+#include <cstring>
+
+void X64Emitter::Push(const Reg reg)
+{
+    Rex(false, 0, 0, reg, false);
+    Emit8(0x50 + (reg & 7));
+}
+
+void X64Emitter::Pop(const Reg reg)
+{
+    Rex(false, 0, 0, reg, false);
+    Emit8(0x58 + (reg & 7));
+}
+
+void X64Emitter::Ret()
+{
+    Emit8(0xC3);
+}
+
+void X64Emitter::MovRegImm64(const Reg dst, const uint64_t imm)
+{
+    Rex(true, 0, 0, dst, false);
+    Emit8(0xB8 + (dst & 7));
+    Emit64(imm);
+}
+
+void X64Emitter::MovRegImm32(const Reg dst, const uint32_t imm)
+{
+    Rex(false, 0, 0, dst, false);
+    Emit8(0xB8 + (dst & 7));
+    Emit32(imm);
+}
+
+void X64Emitter::MovRegReg64(const Reg dst, const Reg src)
+{
+    Rex(true, src, 0, dst, false);
+    Emit8(0x89);
+    ModRMReg(src, dst);
+}
+
+void X64Emitter::MovRegReg32(const Reg dst, const Reg src)
+{
+    Rex(false, src, 0, dst, false);
+    Emit8(0x89);
+    ModRMReg(src, dst);
+}
+
+void X64Emitter::MovReg8Reg8(const Reg dst, const Reg src)
+{
+    Rex(false, src, 0, dst, true);
+    Emit8(0x88);
+    ModRMReg(src, dst);
+}
+
+void X64Emitter::MovReg8Imm8(const Reg dst, const uint8_t imm)
+{
+    Rex(false, 0, 0, dst, true);
+    Emit8(0xB0 + (dst & 7));
+    Emit8(imm);
+}
+
+void X64Emitter::MovzxRegReg8(const Reg dst, const Reg src)
+{
+    Rex(false, dst, 0, src, true);
+    Emit8(0x0F);
+    Emit8(0xB6);
+    ModRMReg(dst, src);
+}
+
+void X64Emitter::LeaReg64(const Reg dst, const int32_t disp)
+{
+    Rex(true, dst, 0, RBX, false);
+    Emit8(0x8D);
+    ModRMMem(dst, disp);
+}
+
+void X64Emitter::MovzxRegMem8(const Reg dst, const int32_t disp)
+{
+    Rex(false, dst, 0, RBX, false);
+    Emit8(0x0F);
+    Emit8(0xB6);
+    ModRMMem(dst, disp);
+}
+
+void X64Emitter::MovzxRegMem16(const Reg dst, const int32_t disp)
+{
+    Rex(false, dst, 0, RBX, false);
+    Emit8(0x0F);
+    Emit8(0xB7);
+    ModRMMem(dst, disp);
+}
+
+void X64Emitter::MovzxRegMem16Indexed(const Reg dst, const int32_t disp, const Reg index)
+{
+    Rex(false, dst, index, RBX, false);
+    Emit8(0x0F);
+    Emit8(0xB7);
+    ModRMMemIndexed(dst, disp, index);
+}
+
+void X64Emitter::MovMemReg8(const int32_t disp, const Reg src)
+{
+    Rex(false, src, 0, RBX, true);
+    Emit8(0x88);
+    ModRMMem(src, disp);
+}
+
+void X64Emitter::MovMemReg16(const int32_t disp, const Reg src)
+{
+    Emit8(0x66);
+    Rex(false, src, 0, RBX, false);
+    Emit8(0x89);
+    ModRMMem(src, disp);
+}
+
+void X64Emitter::MovMemReg16Indexed(const int32_t disp, const Reg index, const Reg src)
+{
+    Emit8(0x66);
+    Rex(false, src, index, RBX, false);
+    Emit8(0x89);
+    ModRMMemIndexed(src, disp, index);
+}
+
+void X64Emitter::MovMemImm8(const int32_t disp, const uint8_t imm)
+{
+    Emit8(0xC6);
+    ModRMMem(0, disp);
+    Emit8(imm);
+}
+
+void X64Emitter::MovMemImm16(const int32_t disp, const uint16_t imm)
+{
+    Emit8(0x66);
+    Emit8(0xC7);
+    ModRMMem(0, disp);
+    Emit16(imm);
+}
+
+void X64Emitter::Alu8RegReg(const AluOp op, const Reg dst, const Reg src)
+{
+    Rex(false, src, 0, dst, true);
+    Emit8(op * 8);
+    ModRMReg(src, dst);
+}
+
+void X64Emitter::Alu8RegImm(const AluOp op, const Reg dst, const uint8_t imm)
+{
+    Rex(false, 0, 0, dst, true);
+    Emit8(0x80);
+    ModRMReg(op, dst);
+    Emit8(imm);
+}
+
+void X64Emitter::Alu8MemImm(const AluOp op, const int32_t disp, const uint8_t imm)
+{
+    Emit8(0x80);
+    ModRMMem(op, disp);
+    Emit8(imm);
+}
+
+void X64Emitter::Alu32RegReg(const AluOp op, const Reg dst, const Reg src)
+{
+    Rex(false, src, 0, dst, false);
+    Emit8(op * 8 + 1);
+    ModRMReg(src, dst);
+}
+
+void X64Emitter::Alu32RegImm(const AluOp op, const Reg dst, const int32_t imm)
+{
+    Rex(false, 0, 0, dst, false);
+    Emit8(0x81);
+    ModRMReg(op, dst);
+    Emit32((uint32_t)imm);
+}
+
+void X64Emitter::Alu64RegImm(const AluOp op, const Reg dst, const int32_t imm)
+{
+    Rex(true, 0, 0, dst, false);
+    Emit8(0x81);
+    ModRMReg(op, dst);
+    Emit32((uint32_t)imm);
+}
+
+void X64Emitter::Shift8Reg(const ShiftOp op, const Reg reg)
+{
+    Rex(false, 0, 0, reg, true);
+    Emit8(0xD0);
+    ModRMReg(op, reg);
+}
+
+void X64Emitter::ImulRegRegImm8(const Reg dst, const Reg src, const int8_t imm)
+{
+    Rex(false, dst, 0, src, false);
+    Emit8(0x6B);
+    ModRMReg(dst, src);
+    Emit8((uint8_t)imm);
+}
+
+void X64Emitter::SetccReg(const Cond cond, const Reg dst)
+{
+    Rex(false, 0, 0, dst, true);
+    Emit8(0x0F);
+    Emit8(0x90 + cond);
+    ModRMReg(0, dst);
+}
+
+void X64Emitter::SetccMem(const Cond cond, const int32_t disp)
+{
+    Emit8(0x0F);
+    Emit8(0x90 + cond);
+    ModRMMem(0, disp);
+}
+
+void X64Emitter::CmovccRegReg(const Cond cond, const Reg dst, const Reg src)
+{
+    Rex(false, dst, 0, src, false);
+    Emit8(0x0F);
+    Emit8(0x40 + cond);
+    ModRMReg(dst, src);
+}
+
+void X64Emitter::CallReg(const Reg reg)
+{
+    Rex(false, 0, 0, reg, false);
+    Emit8(0xFF);
+    ModRMReg(2, reg);
+}
+
+void X64Emitter::JmpReg(const Reg reg)
+{
+    Rex(false, 0, 0, reg, false);
+    Emit8(0xFF);
+    ModRMReg(4, reg);
+}
+
+size_t X64Emitter::Jmp(const size_t target)
+{
+    const size_t rel32Position = JmpForward();
+    PatchRel32(rel32Position, target);
+    return rel32Position;
+}
+
+size_t X64Emitter::Jcc(const Cond cond, const size_t target)
+{
+    const size_t rel32Position = JccForward(cond);
+    PatchRel32(rel32Position, target);
+    return rel32Position;
+}
+
+size_t X64Emitter::JmpForward()
+{
+    Emit8(0xE9);
+    const size_t rel32Position = mPosition;
+    Emit32(0);
+    return rel32Position;
+}
+
+size_t X64Emitter::JccForward(const Cond cond)
+{
+    Emit8(0x0F);
+    Emit8(0x80 + cond);
+    const size_t rel32Position = mPosition;
+    Emit32(0);
+    return rel32Position;
+}
+
+void X64Emitter::PatchRel32(const size_t rel32Position, const size_t target)
+{
+    const int32_t rel = (int32_t)((int64_t)target - (int64_t)(rel32Position + 4));
+    memcpy(mCode + rel32Position, &rel, sizeof(rel));
+}
+
+void X64Emitter::Emit8(const uint8_t value)
+{
+    MAKE_ASSERT(mPosition < mCapacity, "JIT code buffer overflow");
+    mCode[mPosition++] = value;
+}
+
+void X64Emitter::Emit16(const uint16_t value)
+{
+    Emit8(value & 0xFF);
+    Emit8(value >> 8);
+}
+
+void X64Emitter::Emit32(const uint32_t value)
+{
+    Emit16(value & 0xFFFF);
+    Emit16(value >> 16);
+}
+
+void X64Emitter::Emit64(const uint64_t value)
+{
+    Emit32(value & 0xFFFFFFFF);
+    Emit32(value >> 32);
+}
+
+void X64Emitter::Rex(const bool w, const uint8_t reg, const uint8_t index, const uint8_t base, const bool byteRegs)
+{
+    const uint8_t rex = 0x40 | (w ? 0x08 : 0) | ((reg & 8) ? 0x04 : 0) | ((index & 8) ? 0x02 : 0) | ((base & 8) ? 0x01 : 0);
+    const bool needsRex = (rex != 0x40) || (byteRegs && ((reg >= 4 && reg < 8) || (base >= 4 && base < 8)));
+    if (needsRex)
+        Emit8(rex);
+}
+
+void X64Emitter::ModRMReg(const uint8_t reg, const uint8_t rm)
+{
+    Emit8(0xC0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+void X64Emitter::ModRMMem(const uint8_t reg, const int32_t disp)
+{
+    // mod=10 with rm=rbx is [rbx + disp32], no SIB byte needed
+    Emit8(0x80 | ((reg & 7) << 3) | RBX);
+    Emit32((uint32_t)disp);
+}
+
+void X64Emitter::ModRMMemIndexed(const uint8_t reg, const int32_t disp, const uint8_t index)
+{
+    // [rbx + index * 2 + disp32]
+    Emit8(0x80 | ((reg & 7) << 3) | 0x4);
+    Emit8(0x40 | ((index & 7) << 3) | RBX);
+    Emit32((uint32_t)disp);
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Types.h"
+
+#include <cstddef>
+
+// Writes the small subset of x86-64 machine code the JIT needs. Memory operands are
+// always [rbx + disp32], optionally with a word sized index, since compiled code keeps
+// rbx pointed at the emulator state.
+class X64Emitter
+{
+public:
+    enum Reg : uint8_t
+    {
+        RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+        R8, R9, R10, R11, R12, R13, R14, R15
+    };
+
+    enum Cond : uint8_t
+    {
+        CondB = 0x2,  // Below / carry
+        CondAE = 0x3, // Above or equal / no carry
+        CondE = 0x4,
+        CondNE = 0x5,
+        CondA = 0x7,
+        CondS = 0x8
+    };
+
+    enum AluOp : uint8_t
+    {
+        AluAdd = 0,
+        AluOr = 1,
+        AluAnd = 4,
+        AluSub = 5,
+        AluXor = 6,
+        AluCmp = 7
+    };
+
+    enum ShiftOp : uint8_t
+    {
+        ShiftLeft = 4,
+        ShiftRight = 5
+    };
+
+public:
+    X64Emitter() = default;
+    X64Emitter(uint8_t* const code, const size_t capacity) :
+        mCode(code), mCapacity(capacity) {}
+
+    size_t GetPosition() const { return mPosition; }
+    void SetPosition(const size_t position) { mPosition = position; }
+    const uint8_t* GetPointer(const size_t position) const { return mCode + position; }
+    bool HasRoom(const size_t bytes) const { return mPosition + bytes <= mCapacity; }
+
+    void Push(const Reg reg);
+    void Pop(const Reg reg);
+    void Ret();
+
+    void MovRegImm64(const Reg dst, const uint64_t imm);
+    void MovRegImm32(const Reg dst, const uint32_t imm);
+    void MovRegReg64(const Reg dst, const Reg src);
+    void MovRegReg32(const Reg dst, const Reg src);
+    void MovReg8Reg8(const Reg dst, const Reg src);
+    void MovReg8Imm8(const Reg dst, const uint8_t imm);
+    void MovzxRegReg8(const Reg dst, const Reg src);
+    void LeaReg64(const Reg dst, const int32_t disp);
+
+    void MovzxRegMem8(const Reg dst, const int32_t disp);
+    void MovzxRegMem16(const Reg dst, const int32_t disp);
+    void MovzxRegMem16Indexed(const Reg dst, const int32_t disp, const Reg index);
+    void MovMemReg8(const int32_t disp, const Reg src);
+    void MovMemReg16(const int32_t disp, const Reg src);
+    void MovMemReg16Indexed(const int32_t disp, const Reg index, const Reg src);
+    void MovMemImm8(const int32_t disp, const uint8_t imm);
+    void MovMemImm16(const int32_t disp, const uint16_t imm);
+
+    void Alu8RegReg(const AluOp op, const Reg dst, const Reg src);
+    void Alu8RegImm(const AluOp op, const Reg dst, const uint8_t imm);
+    void Alu8MemImm(const AluOp op, const int32_t disp, const uint8_t imm);
+    void Alu32RegReg(const AluOp op, const Reg dst, const Reg src);
+    void Alu32RegImm(const AluOp op, const Reg dst, const int32_t imm);
+    void Alu64RegImm(const AluOp op, const Reg dst, const int32_t imm);
+    void Shift8Reg(const ShiftOp op, const Reg reg);
+    void ImulRegRegImm8(const Reg dst, const Reg src, const int8_t imm);
+
+    void SetccReg(const Cond cond, const Reg dst);
+    void SetccMem(const Cond cond, const int32_t disp);
+    void CmovccRegReg(const Cond cond, const Reg dst, const Reg src);
+
+    void CallReg(const Reg reg);
+    void JmpReg(const Reg reg);
+
+    // Jumps return the position of their rel32 field so it can be patched later
+    size_t Jmp(const size_t target);
+    size_t Jcc(const Cond cond, const size_t target);
+    size_t JmpForward();
+    size_t JccForward(const Cond cond);
+    void PatchRel32(const size_t rel32Position, const size_t target);
+    void BindHere(const size_t rel32Position) { PatchRel32(rel32Position, mPosition); }
+
+private:
+    void Emit8(const uint8_t value);
+    void Emit16(const uint16_t value);
+    void Emit32(const uint32_t value);
+    void Emit64(const uint64_t value);
+
+    // Emits a REX prefix if one is needed. byteRegs forces one so registers 4-7 encode
+    // spl/bpl/sil/dil instead of ah/ch/dh/bh.
+    void Rex(const bool w, const uint8_t reg, const uint8_t index, const uint8_t base, const bool byteRegs);
+
+    void ModRMReg(const uint8_t reg, const uint8_t rm);
+    void ModRMMem(const uint8_t reg, const int32_t disp);
+    void ModRMMemIndexed(const uint8_t reg, const int32_t disp, const uint8_t index);
+
+private:
+    uint8_t* mCode = nullptr;
+    size_t mCapacity = 0;
+    size_t mPosition = 0;
+};
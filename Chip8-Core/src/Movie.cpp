@@ -0,0 +1,283 @@
+#include "Movie.h"
+
+#include "Log.h"
+#include "Utils/DeltaCodec.h"
+#include "Utils/Hash.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+
+bool Movie::StartRecording(Chip8& chip8, const bool withHashes)
+{
+    if (std::empty(chip8.GetGameFile()))
+        return false;
+
+    if (chip8.GetFrameRate() > MAX_FRAME_RATE)
+    {
+        LOG_ERROR("Movies can't be recorded at over {} frames per second", MAX_FRAME_RATE);
+        return false;
+    }
+
+    RestartGame(chip8);
+
+    mRomHash = chip8.GetRomHash();
+    mRandomSeed = chip8.GetRandomSeed();
+    mInstructionsPerSecond = chip8.GetInstructionsPerSecond();
+    mFrameRate = chip8.GetFrameRate();
+    mInputSamplesPerTick = chip8.GetInputSamplesPerTick();
+    mEmuSpeedModifier = chip8.GetEmuSpeedModifier();
+    mQuirks = 0;
+    if (chip8.GetUseVYForShiftQuirk())
+        mQuirks |= QUIRK_VY_FOR_SHIFT;
+    if (chip8.GetUseBXNNQuirk())
+        mQuirks |= QUIRK_BXNN;
+    if (chip8.GetUseIndexIncrementAfterStoreLoadQuirk())
+        mQuirks |= QUIRK_INDEX_INCREMENT;
+    mHasHashes = withHashes;
+
+    mKeys.clear();
+    mHashes.clear();
+    mFrame = 0;
+    mDivergedFrame = NO_FRAME;
+    mMode = Mode::eRecording;
+    return true;
+}
+
+bool Movie::StartPlayback(Chip8& chip8, const bool checkHashes)
+{
+    if (std::empty(chip8.GetGameFile()))
+        return false;
+
+    if (chip8.GetRomHash() != mRomHash)
+    {
+        LOG_ERROR("Movie was made with a different rom than {}", chip8.GetGameFile().string());
+        return false;
+    }
+
+    // The seed is taken when the game loads
+    chip8.SetRandomSeed(mRandomSeed);
+    RestartGame(chip8);
+    ApplySettings(chip8);
+
+    mCheckHashes = checkHashes;
+    mFrame = 0;
+    mDivergedFrame = NO_FRAME;
+    mMode = Mode::ePlaying;
+    return true;
+}
+
+bool Movie::RunFrame(Chip8& chip8, const uint16_t keys)
+{
+    if (mMode == Mode::eIdle || std::empty(chip8.GetGameFile()))
+        return false;
+    if (mMode == Mode::ePlaying && mFrame >= std::size(mKeys))
+        return false;
+    if (mMode == Mode::eRecording && std::size(mKeys) >= GetMaxFrames(mFrameRate))
+        return false;
+
+    ApplySettings(chip8);
+
+    if (mMode == Mode::eRecording)
+    {
+        chip8.EmulateWithKeys(keys);
+        mKeys.push_back(keys);
+        if (mHasHashes)
+            mHashes.push_back(HashFrame(chip8));
+    }
+    else
+    {
+        chip8.EmulateWithKeys(mKeys[mFrame]);
+        if (mHasHashes && mCheckHashes && mDivergedFrame == NO_FRAME && HashFrame(chip8) != mHashes[mFrame])
+        {
+            mDivergedFrame = mFrame;
+            LOG_WARN("Movie playback diverged from the recording at frame {}", mFrame);
+        }
+    }
+
+    ++mFrame;
+    return true;
+}
+
+bool Movie::Save(const std::filesystem::path& filepath) const
+{
+    std::vector<uint8_t> out(sizeof(Header));
+
+    uint32_t numRuns = 0;
+    for (size_t frame = 0; frame < std::size(mKeys);)
+    {
+        size_t end = frame + 1;
+        while (end < std::size(mKeys) && mKeys[end] == mKeys[frame])
+            ++end;
+
+        DeltaCodec::WriteVarint(out, end - frame);
+        out.push_back((uint8_t)mKeys[frame]);
+        out.push_back((uint8_t)(mKeys[frame] >> 8));
+        frame = end;
+        ++numRuns;
+    }
+    const size_t keysSize = std::size(out) - sizeof(Header);
+
+    if (mHasHashes && !std::empty(mHashes))
+    {
+        const size_t offset = std::size(out);
+        out.resize(offset + std::size(mHashes) * sizeof(uint32_t));
+        memcpy(std::data(out) + offset, std::data(mHashes), std::size(mHashes) * sizeof(uint32_t));
+    }
+
+    const uint8_t* const payload = std::data(out) + sizeof(Header);
+    const size_t payloadSize = std::size(out) - sizeof(Header);
+
+    Header header = {};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.headerSize = sizeof(Header);
+    header.romHash = mRomHash;
+    header.randomSeed = mRandomSeed;
+    header.instructionsPerSecond = mInstructionsPerSecond;
+    header.frameRate = mFrameRate;
+    header.inputSamplesPerTick = mInputSamplesPerTick;
+    header.emuSpeedModifier = mEmuSpeedModifier;
+    header.quirks = mQuirks;
+    header.flags = mHasHashes ? HAS_HASHES : 0;
+    header.numFrames = (uint32_t)std::size(mKeys);
+    header.keysSize = (uint32_t)keysSize;
+    header.payloadCrc = Hash::Crc32(payload, payloadSize);
+    memcpy(std::data(out), &header, sizeof(Header));
+
+    std::error_code error;
+    if (filepath.has_parent_path())
+        std::filesystem::create_directories(filepath.parent_path(), error);
+
+    std::ofstream file(filepath, std::ios::out | std::ios::binary | std::ios::trunc);
+    file.write((const char*)std::data(out), std::size(out));
+    if (!file)
+    {
+        LOG_ERROR("Failed to write movie {}", filepath.string());
+        return false;
+    }
+
+    LOG_INFO("Saved {0} frames in {1} key runs to {2}", std::size(mKeys), numRuns, filepath.string());
+    return true;
+}
+
+bool Movie::Load(const std::filesystem::path& filepath)
+{
+    std::ifstream file(filepath, std::ios::in | std::ios::binary);
+    if (!file)
+    {
+        LOG_ERROR("Unable to open movie {}", filepath.string());
+        return false;
+    }
+    const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    Header header = {};
+    if (std::size(data) < sizeof(Header))
+    {
+        LOG_ERROR("{} is too short to be a movie", filepath.string());
+        return false;
+    }
+    memcpy(&header, std::data(data), sizeof(Header));
+
+    if (header.magic != MAGIC)
+    {
+        LOG_ERROR("{} isn't in the .c8movie format", filepath.string());
+        return false;
+    }
+    if (header.version != VERSION || header.headerSize != sizeof(Header))
+    {
+        LOG_ERROR("{0} is movie version {1}, this build reads version {2}", filepath.string(), header.version, VERSION);
+        return false;
+    }
+    if (header.instructionsPerSecond == 0 || header.frameRate == 0 || header.frameRate > MAX_FRAME_RATE ||
+        header.inputSamplesPerTick == 0 || header.emuSpeedModifier == 0)
+    {
+        LOG_ERROR("Movie {} has settings the Chip8 can't run at", filepath.string());
+        return false;
+    }
+    if (header.numFrames > GetMaxFrames(header.frameRate))
+    {
+        LOG_ERROR("Movie {0} is longer than the {1} hours a movie can be", filepath.string(), MAX_HOURS);
+        return false;
+    }
+
+    const bool hasHashes = (header.flags & HAS_HASHES) != 0;
+    const uint8_t* const payload = std::data(data) + sizeof(Header);
+    const size_t payloadSize = std::size(data) - sizeof(Header);
+    const size_t hashesSize = hasHashes ? (size_t)header.numFrames * sizeof(uint32_t) : 0;
+    if (header.keysSize > payloadSize || payloadSize - header.keysSize != hashesSize ||
+        header.payloadCrc != Hash::Crc32(payload, payloadSize))
+    {
+        LOG_ERROR("Movie {} is damaged", filepath.string());
+        return false;
+    }
+
+    // The keys grow as the runs decode, so a movie claiming more frames than its runs hold
+    // never gets the memory for them
+    std::vector<uint16_t> keys;
+    const uint8_t* in = payload;
+    const uint8_t* const keysEnd = payload + header.keysSize;
+    while (in < keysEnd)
+    {
+        size_t frames = 0;
+        if (!DeltaCodec::ReadVarint(in, keysEnd, frames) || keysEnd - in < 2 || frames > header.numFrames - std::size(keys))
+        {
+            LOG_ERROR("Movie {} is damaged", filepath.string());
+            return false;
+        }
+
+        keys.insert(std::end(keys), frames, (uint16_t)(in[0] | (in[1] << 8)));
+        in += 2;
+    }
+    if (std::size(keys) != header.numFrames)
+    {
+        LOG_ERROR("Movie {} is damaged", filepath.string());
+        return false;
+    }
+
+    mHashes.resize(hasHashes ? header.numFrames : 0);
+    if (hashesSize > 0)
+        memcpy(std::data(mHashes), keysEnd, hashesSize);
+    mKeys = std::move(keys);
+
+    mRomHash = header.romHash;
+    mRandomSeed = header.randomSeed;
+    mInstructionsPerSecond = header.instructionsPerSecond;
+    mFrameRate = header.frameRate;
+    mInputSamplesPerTick = header.inputSamplesPerTick;
+    mEmuSpeedModifier = header.emuSpeedModifier;
+    mQuirks = header.quirks;
+    mHasHashes = hasHashes;
+
+    mFrame = 0;
+    mDivergedFrame = NO_FRAME;
+    mMode = Mode::eIdle;
+    return true;
+}
+
+void Movie::ApplySettings(Chip8& chip8) const
+{
+    chip8.SetInstructionsPerSecond(mInstructionsPerSecond);
+    chip8.SetFrameRate(mFrameRate);
+    chip8.SetInputSamplesPerTick(mInputSamplesPerTick);
+    chip8.SetEmuSpeedModifier(mEmuSpeedModifier);
+    chip8.SetUseVYForShiftQuirk(mQuirks & QUIRK_VY_FOR_SHIFT);
+    chip8.SetUseBXNNQuirk(mQuirks & QUIRK_BXNN);
+    chip8.SetUseIndexIncrementAfterStoreLoadQuirk(mQuirks & QUIRK_INDEX_INCREMENT);
+}
+
+void Movie::RestartGame(Chip8& chip8)
+{
+    // Loading resets the frame rate along with the rest of the machine
+    const uint32_t frameRate = chip8.GetFrameRate();
+    const std::filesystem::path game = chip8.GetGameFile();
+    chip8.LoadGame(game);
+    chip8.SetFrameRate(frameRate);
+}
+
+uint32_t Movie::HashFrame(const Chip8& chip8)
+{
+    const uint64_t hash = chip8.HashState();
+    return (uint32_t)(hash ^ (hash >> 32));
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "Chip8.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+/*
+ * An input movie: the keys held in each frame of a run from power on, with everything else
+ * that decides what the game does with them, so the run can be played back exactly, headless or
+ * in the emulator.
+ *
+ * A movie is made of Chip8::EmulateWithKeys() frames, so the keys are read once per frame. The
+ * .c8movie file starts with a fixed header holding the magic "C8MV", the format version, a hash
+ * of the rom, the random seed, the instruction rate, frame rate, input samples per tick, speed
+ * modifier and quirks, the frame count and a CRC-32 of the payload. The payload is the keys as
+ * runs, each a LEB128 varint frame count and the 16-bit keys held for them, then optionally a
+ * 32-bit hash of the state after every frame for playback to check against. The backend isn't
+ * kept, since they all run the same, so a movie recorded on one plays back on any of them.
+ */
+class Movie
+{
+public:
+    // "C8MV" when read as bytes
+    static constexpr uint32_t MAGIC = 0x564D3843;
+    static constexpr uint16_t VERSION = 1;
+    // No frame has diverged
+    static constexpr uint64_t NO_FRAME = ~0ull;
+    // The longest movie, at its own frame rate. Recording stops there, and Load takes nothing
+    // longer, so a damaged frame count can't have it decode gigabytes of keys.
+    static constexpr uint64_t MAX_HOURS = 8;
+    static constexpr uint32_t MAX_FRAME_RATE = 1000;
+
+    enum class Mode
+    {
+        eIdle,
+        eRecording,
+        ePlaying
+    };
+
+public:
+    // Restarts the loaded game from power on and starts a new movie of it with the Chip8's
+    // settings. withHashes also keeps the state hash after every frame. Fails if the frame rate
+    // is over MAX_FRAME_RATE.
+    bool StartRecording(Chip8& chip8, const bool withHashes);
+    // Restarts the loaded game from power on with the movie's settings and starts playing it
+    // back. Fails if the game isn't the rom the movie was made with. Leaving the hashes unchecked
+    // keeps them out of timed runs.
+    bool StartPlayback(Chip8& chip8, const bool checkHashes = true);
+    // Whatever was recorded so far stays in the movie
+    void Stop() { mMode = Mode::eIdle; }
+
+    // Runs the next frame, with the given keys while recording and the movie's own while playing.
+    // The movie's settings are put back before every frame, so a frontend changing them midway
+    // can't break the movie. Returns false without running anything when idle, at the end of
+    // playback, once a recording is MAX_HOURS long or once the game has exited.
+    bool RunFrame(Chip8& chip8, const uint16_t keys);
+
+    // Both log why they fail
+    bool Save(const std::filesystem::path& filepath) const;
+    bool Load(const std::filesystem::path& filepath);
+
+    Mode GetMode() const { return mMode; }
+    bool IsActive() const { return mMode != Mode::eIdle; }
+    // Frames run since recording or playback started
+    uint64_t GetFrame() const { return mFrame; }
+    uint64_t GetNumFrames() const { return std::size(mKeys); }
+    bool HasHashes() const { return mHasHashes; }
+    uint64_t GetRomHash() const { return mRomHash; }
+    // The first frame played back whose state hash differed from the recorded one, or NO_FRAME.
+    // The frames after it still play but no longer mean much.
+    uint64_t GetDivergedFrame() const { return mDivergedFrame; }
+
+private:
+    struct Header
+    {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t headerSize;
+        uint64_t romHash;
+        uint64_t randomSeed;
+        uint32_t instructionsPerSecond;
+        uint32_t frameRate;
+        uint32_t inputSamplesPerTick;
+        uint8_t emuSpeedModifier;
+        uint8_t quirks;
+        uint16_t flags;
+        uint32_t numFrames;
+        uint32_t keysSize;
+        uint32_t payloadCrc;
+        uint32_t reserved;
+    };
+    static_assert(sizeof(Header) == 56, "Header layout is part of the file format");
+
+    // Header flags
+    static constexpr uint16_t HAS_HASHES = 1 << 0;
+
+    // Quirk bits, in the same order as Chip8-Bench numbers its quirk profiles
+    static constexpr uint8_t QUIRK_VY_FOR_SHIFT = 1 << 0;
+    static constexpr uint8_t QUIRK_BXNN = 1 << 1;
+    static constexpr uint8_t QUIRK_INDEX_INCREMENT = 1 << 2;
+
+private:
+    void ApplySettings(Chip8& chip8) const;
+    static void RestartGame(Chip8& chip8);
+    // The state hash folded to the 32 bits kept per frame
+    static uint32_t HashFrame(const Chip8& chip8);
+    static uint64_t GetMaxFrames(const uint32_t frameRate) { return MAX_HOURS * 3600 * frameRate; }
+
+private:
+    Mode mMode = Mode::eIdle;
+
+    uint64_t mRomHash = 0;
+    uint64_t mRandomSeed = 0;
+    uint32_t mInstructionsPerSecond = Chip8::DEFAULT_INSTRUCTIONS_PER_SECOND;
+    uint32_t mFrameRate = 60;
+    uint32_t mInputSamplesPerTick = 1;
+    uint8_t mEmuSpeedModifier = 1;
+    uint8_t mQuirks = 0;
+    bool mHasHashes = false;
+    bool mCheckHashes = true;
+
+    // One entry per frame
+    std::vector<uint16_t> mKeys;
+    std::vector<uint32_t> mHashes;
+
+    uint64_t mFrame = 0;
+    uint64_t mDivergedFrame = NO_FRAME;
+};
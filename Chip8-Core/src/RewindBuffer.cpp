@@ -0,0 +1,183 @@
+#include "RewindBuffer.h"
+
+#include <cstring>
+
+RewindBuffer::RewindBuffer(const size_t budget) :
+    mState(Chip8::STATE_SIZE),
+    mNext(Chip8::STATE_SIZE)
+{
+    mEncoded.reserve(DeltaCodec::MaxEncodedSize(Chip8::STATE_SIZE));
+    SetBudget(budget);
+}
+
+void RewindBuffer::SetBudget(const size_t budget)
+{
+    // Left uninitialised, so the pages are only committed once states are written to them
+    mBuffer.reset((budget > 0) ? new uint8_t[budget] : nullptr);
+    mBudget = budget;
+    Clear();
+}
+
+void RewindBuffer::Record(Chip8& chip8)
+{
+    if (mBudget == 0)
+        return;
+
+    const std::filesystem::path& game = chip8.GetGameFile();
+    if (game != mGameFile)
+    {
+        Clear();
+        mGameFile = game;
+    }
+    if (std::empty(game))
+        return;
+
+    const Chip8::StatePages written = chip8.TakeWrittenPages();
+    chip8.WriteState(std::data(mNext), false);
+    const uint8_t* const memory = std::data(chip8.GetMemory());
+
+    mEncoded.clear();
+    if (mCopyAllPages)
+    {
+        // There's nothing older to step back to, so the first state is stored without a delta
+        mState = mNext;
+        memcpy(std::data(mState) + Chip8::STATE_MEMORY_OFFSET, memory, Chip8::MEM_SIZE);
+        mCopyAllPages = false;
+    }
+    else
+    {
+        Encode(memory, written);
+    }
+
+    Store();
+}
+
+bool RewindBuffer::StepBack(Chip8& chip8)
+{
+    if (std::size(mEntries) < 2)
+        return false;
+
+    const Entry newest = mEntries.back();
+    mEntries.pop_back();
+    mUsedBytes -= newest.size;
+    mWritePos = newest.offset;
+
+    // The newest state is the one before it XOR'd with its entry, so XORing the entry in again
+    // gives the one before back
+    const uint8_t* const in = mBuffer.get() + newest.offset;
+    DeltaCodec::Decode(in, in + newest.size, std::data(mState), Chip8::STATE_SIZE, [](const size_t, const size_t) {});
+
+    chip8.ReadState(std::data(mState));
+    // mState already holds all of the memory that was just read
+    chip8.TakeWrittenPages();
+    return true;
+}
+
+void RewindBuffer::Clear()
+{
+    mEntries.clear();
+    mWritePos = 0;
+    mUsedBytes = 0;
+    mGameFile.clear();
+    mCopyAllPages = true;
+}
+
+void RewindBuffer::Encode(const uint8_t* const memory, const Chip8::StatePages pages)
+{
+    DeltaCodec::Encoder encoder(mEncoded);
+    uint8_t* const state = std::data(mState);
+    const uint8_t* const next = std::data(mNext);
+
+    EncodeWords(encoder, next, state, Chip8::STATE_MEMORY_OFFSET);
+
+    // Pages that weren't written since the last record can't differ from it, so they're skipped
+    // without being looked at
+    for (uint32_t page = 0; page < Chip8::NUM_STATE_PAGES; ++page)
+    {
+        const size_t begin = Chip8::STATE_MEMORY_OFFSET + page * Chip8::STATE_PAGE_SIZE;
+        if ((pages >> page) & 1)
+        {
+            const uint8_t* const source = memory + page * Chip8::STATE_PAGE_SIZE;
+            encoder.Encode(source, state + begin, Chip8::STATE_PAGE_SIZE);
+            memcpy(state + begin, source, Chip8::STATE_PAGE_SIZE);
+        }
+        else
+        {
+            encoder.Skip(Chip8::STATE_PAGE_SIZE);
+        }
+    }
+
+    const size_t vramBegin = Chip8::STATE_MEMORY_OFFSET + Chip8::MEM_SIZE;
+    EncodeWords(encoder, next + vramBegin, state + vramBegin, Chip8::STATE_SIZE - vramBegin);
+}
+
+// The registers and VRAM mostly hold what they held a frame ago, so only the runs of words that
+// changed go through the encoder
+void RewindBuffer::EncodeWords(DeltaCodec::Encoder& encoder, const uint8_t* const next, uint8_t* const state, const size_t size)
+{
+    static_assert(Chip8::STATE_MEMORY_OFFSET % sizeof(uint64_t) == 0, "The registers have to be whole words");
+
+    size_t pos = 0;
+    while (pos < size)
+    {
+        size_t begin = pos;
+        while (begin < size && memcmp(next + begin, state + begin, sizeof(uint64_t)) == 0)
+            begin += sizeof(uint64_t);
+        encoder.Skip(begin - pos);
+        if (begin == size)
+            break;
+
+        size_t end = begin + sizeof(uint64_t);
+        while (end < size && memcmp(next + end, state + end, sizeof(uint64_t)) != 0)
+            end += sizeof(uint64_t);
+
+        encoder.Encode(next + begin, state + begin, end - begin);
+        memcpy(state + begin, next + begin, end - begin);
+        pos = end;
+    }
+}
+
+void RewindBuffer::Store()
+{
+    // The ring is kept in order by where entries sit in it, so a frame that changed nothing still
+    // takes a token that changes nothing
+    if (std::empty(mEncoded))
+    {
+        DeltaCodec::WriteVarint(mEncoded, 0);
+        DeltaCodec::WriteVarint(mEncoded, 0);
+    }
+
+    const size_t size = std::size(mEncoded);
+    if (size > mBudget)
+    {
+        // Too big to keep, which leaves nothing to step back to. mState is still this state, so
+        // recording carries on from it.
+        mEntries.clear();
+        mUsedBytes = 0;
+        mWritePos = 0;
+        return;
+    }
+
+    if (mWritePos + size > mBudget)
+    {
+        // Entries past the write position are the oldest ones, and wrapping around drops them
+        while (!std::empty(mEntries) && mEntries.front().offset >= mWritePos)
+        {
+            mUsedBytes -= mEntries.front().size;
+            mEntries.pop_front();
+        }
+        mWritePos = 0;
+    }
+
+    while (!std::empty(mEntries) && mEntries.front().offset < mWritePos + size &&
+        mWritePos < mEntries.front().offset + mEntries.front().size)
+    {
+        mUsedBytes -= mEntries.front().size;
+        mEntries.pop_front();
+    }
+
+    memcpy(mBuffer.get() + mWritePos, std::data(mEncoded), size);
+    mEntries.push_back({ mWritePos, (uint32_t)size });
+    mWritePos += size;
+    mUsedBytes += size;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Chip8.h"
+#include "Utils/DeltaCodec.h"
+
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+/*
+ * Records a Chip8 state every frame into a ring of fixed size, to step back through them.
+ *
+ * Each state is packed with DeltaCodec against the one recorded before it, and the newest state
+ * is kept whole, so stepping back XORs the newest entry out of it to get the one before. Only
+ * the memory pages the Chip8 wrote since the last record are compared, and the registers and
+ * VRAM are compared a word at a time, so a frame costs about what it changed. Stepping back
+ * never reaches past the oldest entry, so when the ring is full the oldest one is just dropped.
+ */
+class RewindBuffer
+{
+public:
+    static constexpr size_t DEFAULT_BUDGET = 64 * 1024 * 1024;
+
+public:
+    RewindBuffer(const size_t budget = DEFAULT_BUDGET);
+
+    RewindBuffer(const RewindBuffer&) = delete;
+    RewindBuffer& operator=(const RewindBuffer&) = delete;
+
+    // Bytes the ring holds. Changing it drops everything recorded and 0 turns recording off.
+    size_t GetBudget() const { return mBudget; }
+    void SetBudget(const size_t budget);
+
+    // Records the state the Chip8 is in now. Loading another game starts over.
+    void Record(Chip8& chip8);
+    // Puts the Chip8 back to the state recorded before the newest one, which is forgotten.
+    // Returns false once there's nothing older left.
+    bool StepBack(Chip8& chip8);
+    void Clear();
+
+    size_t GetNumStates() const { return std::size(mEntries); }
+    size_t GetUsedBytes() const { return mUsedBytes; }
+
+private:
+    struct Entry
+    {
+        size_t offset = 0;
+        uint32_t size = 0;
+    };
+
+private:
+    // Packs the state being recorded against mState, bringing mState up to it
+    void Encode(const uint8_t* const memory, const Chip8::StatePages pages);
+    void EncodeWords(DeltaCodec::Encoder& encoder, const uint8_t* const next, uint8_t* const state, const size_t size);
+
+    void Store();
+
+private:
+    std::unique_ptr<uint8_t[]> mBuffer;
+    size_t mBudget = 0;
+    size_t mWritePos = 0;
+    size_t mUsedBytes = 0;
+    std::deque<Entry> mEntries;
+
+    std::filesystem::path mGameFile;
+    // The newest state, whole. mState only gets the memory pages written since the last record,
+    // so all of it is copied again after a clear.
+    std::vector<uint8_t> mState;
+    bool mCopyAllPages = true;
+    // The registers and VRAM of the state being recorded
+    std::vector<uint8_t> mNext;
+
+    // The entry being encoded
+    std::vector<uint8_t> mEncoded;
+};
@@ -0,0 +1,129 @@
+#include "SaveSlotStore.h"
+
+#include "Log.h"
+
+#include <cstring>
+#include <fstream>
+#include <system_error>
+
+bool SaveSlotStore::Open(const std::filesystem::path& filepath, const bool create)
+{
+    Close();
+
+    std::error_code error;
+    if (std::filesystem::exists(filepath, error))
+    {
+        FileHeader header = {};
+        std::ifstream file(filepath, std::ios::in | std::ios::binary);
+        file.read((char*)&header, sizeof(FileHeader));
+        file.close();
+
+        if (std::filesystem::file_size(filepath, error) != FILE_SIZE || header.magic != MAGIC ||
+            header.version != VERSION || header.numSlots != NUM_SLOTS || header.slotSize != SLOT_SIZE)
+        {
+            std::filesystem::path oldPath = filepath;
+            oldPath += ".old";
+            LOG_WARN("{0} was written with another slot layout, moving it to {1}", filepath.string(), oldPath.string());
+            std::filesystem::rename(filepath, oldPath, error);
+            if (error)
+            {
+                LOG_ERROR("Failed to move {}: {}", filepath.string(), error.message());
+                return false;
+            }
+        }
+    }
+    else if (!create)
+    {
+        return false;
+    }
+    else if (filepath.has_parent_path())
+    {
+        std::filesystem::create_directories(filepath.parent_path(), error);
+    }
+
+    if (!mFile.Open(filepath, FILE_SIZE))
+        return false;
+
+    // A new file comes up all zeros, which is every slot empty
+    FileHeader header = {};
+    memcpy(&header, mFile.GetData(), sizeof(FileHeader));
+    if (header.magic != MAGIC)
+    {
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.numSlots = NUM_SLOTS;
+        header.slotSize = SLOT_SIZE;
+        memcpy(mFile.GetData(), &header, sizeof(FileHeader));
+    }
+
+    return true;
+}
+
+bool SaveSlotStore::Write(const uint32_t slot, const uint8_t* const data, const size_t size, const Chip8::SaveSync sync)
+{
+    if (!IsOpen() || slot >= NUM_SLOTS || size > MAX_CONTAINER_SIZE)
+        return false;
+
+    const uint64_t generation = GetGeneration(slot) + 1;
+    const size_t offset = GetHalfOffset(slot, generation & 1);
+    uint8_t* const dest = mFile.GetData() + offset;
+    const uint64_t storedSize = size;
+    memcpy(dest + sizeof(uint64_t), data, size);
+    memcpy(dest, &storedSize, sizeof(uint64_t));
+    Sync(offset, sizeof(uint64_t) + size, sync);
+
+    memcpy(mFile.GetData() + GetGenerationOffset(slot), &generation, sizeof(uint64_t));
+    Sync(GetGenerationOffset(slot), sizeof(uint64_t), sync);
+    return true;
+}
+
+const uint8_t* SaveSlotStore::Read(const uint32_t slot, size_t& size) const
+{
+    size = 0;
+    if (!IsOpen() || slot >= NUM_SLOTS)
+        return nullptr;
+
+    const uint64_t half = GetGeneration(slot) & 1;
+    const uint8_t* const data = ReadHalf(slot, half, size);
+    if (data && SaveStateFile::IsWhole(data, size))
+        return data;
+
+    size_t previousSize = 0;
+    const uint8_t* const previous = ReadHalf(slot, half ^ 1, previousSize);
+    if (previous && SaveStateFile::IsWhole(previous, previousSize))
+    {
+        LOG_WARN("Save slot {} was only partly written, reading the save before it", slot + 1);
+        size = previousSize;
+        return previous;
+    }
+
+    // Loading says what's wrong with it
+    return data;
+}
+
+uint64_t SaveSlotStore::GetGeneration(const uint32_t slot) const
+{
+    uint64_t generation = 0;
+    memcpy(&generation, mFile.GetData() + GetGenerationOffset(slot), sizeof(uint64_t));
+    return generation;
+}
+
+const uint8_t* SaveSlotStore::ReadHalf(const uint32_t slot, const uint64_t half, size_t& size) const
+{
+    size = 0;
+    const uint8_t* const src = mFile.GetData() + GetHalfOffset(slot, half);
+    uint64_t storedSize = 0;
+    memcpy(&storedSize, src, sizeof(uint64_t));
+    // Anything bigger than a half can hold is garbage, which the caller sees as an empty slot
+    if (storedSize > MAX_CONTAINER_SIZE)
+        return nullptr;
+
+    size = (size_t)storedSize;
+    return src + sizeof(uint64_t);
+}
+
+void SaveSlotStore::Sync(const size_t offset, const size_t size, const Chip8::SaveSync sync)
+{
+    if (sync != Chip8::SaveSync::eNone)
+        mFile.Sync(offset, size, sync == Chip8::SaveSync::eSync);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Chip8.h"
+#include "SaveStateFile.h"
+#include "Utils/DeltaCodec.h"
+#include "Utils/MappedFile.h"
+
+#include <cstdint>
+#include <filesystem>
+
+/*
+ * All the save slots of a rom in one preallocated file mapped into memory, so once the file is
+ * open saving or loading a slot is a memcpy with no file calls.
+ *
+ * The file starts with a page holding the magic "C8SL", the layout version, the slot count and
+ * the slot size, then a generation count per slot. Each slot after it is two page aligned halves,
+ * each holding the size of the .c8state container in it, 0 while empty, then the container. The
+ * generation's low bit picks the half holding the slot's save. A save is written to the other
+ * half, and the generation only moves on to it after that, so a save torn by the machine going
+ * down leaves the one before it in place. If the generation reached the disk before the half it
+ * points at, the container's CRC shows it and reading falls back to the other half.
+ */
+class SaveSlotStore
+{
+public:
+    static constexpr uint32_t NUM_SLOTS = 10;
+    // "C8SL" when read as bytes
+    static constexpr uint32_t MAGIC = 0x4C533843;
+    static constexpr uint16_t VERSION = 2;
+
+    static constexpr size_t SLOT_ALIGNMENT = 4096;
+    static constexpr size_t MAX_CONTAINER_SIZE = sizeof(SaveStateFile::Header) + DeltaCodec::MaxEncodedSize(Chip8::STATE_SIZE);
+    static constexpr size_t HALF_SIZE = (sizeof(uint64_t) + MAX_CONTAINER_SIZE + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT * SLOT_ALIGNMENT;
+    static constexpr size_t SLOT_SIZE = 2 * HALF_SIZE;
+    static constexpr size_t FILE_SIZE = SLOT_ALIGNMENT + NUM_SLOTS * SLOT_SIZE;
+
+public:
+    SaveSlotStore() = default;
+
+    SaveSlotStore(const SaveSlotStore&) = delete;
+    SaveSlotStore& operator=(const SaveSlotStore&) = delete;
+
+    // Maps the file, creating it if create is set. A file with another layout is moved aside to
+    // a .old file next to it and started over.
+    bool Open(const std::filesystem::path& filepath, const bool create);
+    void Close() { mFile.Close(); }
+    bool IsOpen() const { return mFile.IsOpen(); }
+
+    // Slots are numbered from 0. Write returns false if the container doesn't fit, which
+    // MAX_CONTAINER_SIZE rules out for a packed state. sync says how far to see the save and
+    // then the generation pointing at it to the disk.
+    bool Write(const uint32_t slot, const uint8_t* const data, const size_t size, const Chip8::SaveSync sync);
+    // The container in the slot, straight from the mapping, with size 0 if the slot is empty
+    const uint8_t* Read(const uint32_t slot, size_t& size) const;
+
+private:
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t numSlots;
+        uint64_t slotSize;
+    };
+
+    static_assert(sizeof(FileHeader) + NUM_SLOTS * sizeof(uint64_t) <= SLOT_ALIGNMENT, "Generations must fit the header page");
+
+private:
+    size_t GetGenerationOffset(const uint32_t slot) const { return sizeof(FileHeader) + slot * sizeof(uint64_t); }
+    size_t GetHalfOffset(const uint32_t slot, const uint64_t half) const { return SLOT_ALIGNMENT + slot * SLOT_SIZE + half * HALF_SIZE; }
+    uint64_t GetGeneration(const uint32_t slot) const;
+    // The container in one half, or null if its size is garbage
+    const uint8_t* ReadHalf(const uint32_t slot, const uint64_t half, size_t& size) const;
+    void Sync(const size_t offset, const size_t size, const Chip8::SaveSync sync);
+
+private:
+    MappedFile mFile;
+};
@@ -0,0 +1,88 @@
+#include "SaveStateFile.h"
+
+#include "Log.h"
+#include "Utils/DeltaCodec.h"
+#include "Utils/Hash.h"
+
+#include <cstring>
+
+namespace SaveStateFile
+{
+    bool IsWhole(const uint8_t* const data, const size_t size)
+    {
+        Header header = {};
+        if (size < sizeof(Header))
+            return false;
+        memcpy(&header, data, sizeof(Header));
+
+        const uint8_t* const payload = data + sizeof(Header);
+        return header.magic == MAGIC && header.headerSize == sizeof(Header) && header.payloadSize == size - sizeof(Header) &&
+            header.payloadCrc == Hash::Crc32(payload, header.payloadSize);
+    }
+
+    void Pack(const uint8_t* const state, const uint8_t* const base, const size_t stateSize,
+        const uint64_t romHash, std::vector<uint8_t>& out)
+    {
+        out.resize(sizeof(Header));
+        DeltaCodec::Encoder encoder(out);
+        encoder.Encode(state, base, stateSize);
+
+        const uint8_t* const payload = std::data(out) + sizeof(Header);
+        const size_t payloadSize = std::size(out) - sizeof(Header);
+
+        Header header = {};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.headerSize = sizeof(Header);
+        header.romHash = romHash;
+        header.stateSize = (uint32_t)stateSize;
+        header.payloadSize = (uint32_t)payloadSize;
+        header.payloadCrc = Hash::Crc32(payload, payloadSize);
+        memcpy(std::data(out), &header, sizeof(Header));
+    }
+
+    bool Unpack(const uint8_t* const data, const size_t size, const uint8_t* const base,
+        const size_t stateSize, const uint64_t romHash, uint8_t* const state)
+    {
+        Header header = {};
+        if (size < sizeof(Header))
+        {
+            LOG_ERROR("Save state is too short to be one");
+            return false;
+        }
+        memcpy(&header, data, sizeof(Header));
+
+        if (header.magic != MAGIC)
+        {
+            LOG_ERROR("Save state isn't in the .c8state format");
+            return false;
+        }
+        if (header.version != VERSION || header.headerSize != sizeof(Header) || header.stateSize != stateSize)
+        {
+            LOG_ERROR("Save state is version {} with {} state bytes, this build reads version {} with {}",
+                header.version, header.stateSize, VERSION, stateSize);
+            return false;
+        }
+        if (header.romHash != romHash)
+        {
+            LOG_ERROR("Save state was made with a different rom");
+            return false;
+        }
+
+        const uint8_t* const payload = data + sizeof(Header);
+        if (header.payloadSize != size - sizeof(Header) || header.payloadCrc != Hash::Crc32(payload, header.payloadSize))
+        {
+            LOG_ERROR("Save state is damaged");
+            return false;
+        }
+
+        memcpy(state, base, stateSize);
+        if (!DeltaCodec::Decode(payload, payload + header.payloadSize, state, stateSize, [](const size_t, const size_t) {}))
+        {
+            LOG_ERROR("Save state is damaged");
+            return false;
+        }
+
+        return true;
+    }
+}
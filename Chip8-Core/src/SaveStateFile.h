@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * The .c8state container around a Chip8 state.
+ *
+ * A fixed header with a magic number, the format version, a hash of the rom the state belongs
+ * to, the state size and a CRC-32 of the payload, then the payload. The payload is the state
+ * packed with DeltaCodec against the state the rom starts from. Most of memory is still the
+ * font and the rom, so a typical state comes down to its registers, the bytes the game wrote and
+ * the lit parts of VRAM.
+ */
+namespace SaveStateFile
+{
+    // "C8ST" when read as bytes
+    constexpr uint32_t MAGIC = 0x54533843;
+    constexpr uint16_t VERSION = 1;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t headerSize;
+        uint64_t romHash;
+        uint32_t stateSize;
+        uint32_t payloadSize;
+        uint32_t payloadCrc;
+        uint32_t reserved;
+    };
+    static_assert(sizeof(Header) == 32, "Header layout is part of the file format");
+
+    // Whether the container has a header of this format and a payload matching its CRC, without
+    // logging anything. Unpack checks this and more.
+    bool IsWhole(const uint8_t* const data, const size_t size);
+    // Replaces out with the container for a state of stateSize bytes, packed against base
+    void Pack(const uint8_t* const state, const uint8_t* const base, const size_t stateSize,
+        const uint64_t romHash, std::vector<uint8_t>& out);
+    // Unpacks the container into state, packed against base. Returns false and logs why if it
+    // isn't a state of this version and size, belongs to another rom or is damaged, in which
+    // case state is left undefined.
+    bool Unpack(const uint8_t* const data, const size_t size, const uint8_t* const base,
+        const size_t stateSize, const uint64_t romHash, uint8_t* const state);
+}
@@ -0,0 +1,78 @@
+#include "DeltaCodec.h"
+
+#include <cstring>
+
+namespace DeltaCodec
+{
+    void Encoder::Encode(const uint8_t* const data, const uint8_t* const base, const size_t size)
+    {
+        size_t pos = 0;
+        while (pos < size)
+        {
+            // Equal bytes, a word at a time while there's a word left
+            size_t equalEnd = pos;
+            while (equalEnd + sizeof(uint64_t) <= size && memcmp(data + equalEnd, base + equalEnd, sizeof(uint64_t)) == 0)
+                equalEnd += sizeof(uint64_t);
+            while (equalEnd < size && data[equalEnd] == base[equalEnd])
+                ++equalEnd;
+
+            mPendingZeros += equalEnd - pos;
+            pos = equalEnd;
+            if (pos == size)
+                break;
+
+            // Differing bytes, up to the next run of equal ones long enough to end the literal
+            size_t literalEnd = pos + 1;
+            size_t equal = 0;
+            while (literalEnd + equal < size && equal < MIN_ZERO_RUN)
+            {
+                if (data[literalEnd + equal] == base[literalEnd + equal])
+                {
+                    ++equal;
+                }
+                else
+                {
+                    literalEnd += equal + 1;
+                    equal = 0;
+                }
+            }
+
+            WriteToken(data + pos, base + pos, literalEnd - pos);
+            pos = literalEnd;
+        }
+    }
+
+    void Encoder::WriteToken(const uint8_t* const data, const uint8_t* const base, const size_t size)
+    {
+        WriteVarint(mOut, mPendingZeros);
+        WriteVarint(mOut, size);
+        mPendingZeros = 0;
+
+        for (size_t i = 0; i < size; ++i)
+            mOut.push_back(data[i] ^ base[i]);
+    }
+
+    void WriteVarint(std::vector<uint8_t>& out, size_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((uint8_t)value);
+    }
+
+    bool ReadVarint(const uint8_t*& in, const uint8_t* const end, size_t& value)
+    {
+        value = 0;
+        for (uint32_t shift = 0; in < end && shift < 64; shift += 7)
+        {
+            const uint8_t byte = *in++;
+            value |= (size_t)(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+
+        return false;
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Packs a buffer as its XOR against a base buffer of the same size, which is zero wherever
+ * nothing changed. The result is a list of tokens, each the number of equal bytes before it and
+ * the number of differing bytes after it as LEB128 varints, followed by those bytes XOR'd with the
+ * base. Equal bytes at the end are implied by the buffer size.
+ */
+namespace DeltaCodec
+{
+    // Equal bytes shorter than this stay inside a literal, where they cost less than a new token
+    constexpr size_t MIN_ZERO_RUN = 8;
+
+    constexpr size_t VarintSize(const size_t value)
+    {
+        size_t bytes = 1;
+        for (size_t rest = value >> 7; rest != 0; rest >>= 7)
+            ++bytes;
+        return bytes;
+    }
+
+    // The most that size bytes packed in one Encode call can take. Every token holds at least one
+    // byte and tokens are at least MIN_ZERO_RUN bytes apart, so there's at most one per
+    // MIN_ZERO_RUN + 1 bytes.
+    constexpr size_t MaxEncodedSize(const size_t size)
+    {
+        return size + (size / (MIN_ZERO_RUN + 1) + 1) * 2 * VarintSize(size);
+    }
+
+    class Encoder
+    {
+    public:
+        // Appends the tokens to out
+        explicit Encoder(std::vector<uint8_t>& out) : mOut(out) {}
+
+        // Packs the next size bytes of the buffer against the same bytes of the base
+        void Encode(const uint8_t* const data, const uint8_t* const base, const size_t size);
+        // Passes over the next size bytes without looking at them, for ranges the caller knows
+        // are equal to the base
+        void Skip(const size_t size) { mPendingZeros += size; }
+
+    private:
+        void WriteToken(const uint8_t* const data, const uint8_t* const base, const size_t size);
+
+    private:
+        std::vector<uint8_t>& mOut;
+        // Equal bytes seen since the last token
+        size_t mPendingZeros = 0;
+    };
+
+    void WriteVarint(std::vector<uint8_t>& out, size_t value);
+    bool ReadVarint(const uint8_t*& in, const uint8_t* const end, size_t& value);
+
+    // Applies the tokens between in and end to data, which holds the size bytes of the base, and
+    // calls onChange(offset, length) for every range they change. Returns false if the tokens are
+    // cut short or reach past the end of the buffer, leaving data partly applied.
+    template <typename Func>
+    bool Decode(const uint8_t* in, const uint8_t* const end, uint8_t* const data, const size_t size, Func&& onChange)
+    {
+        size_t pos = 0;
+        while (in < end)
+        {
+            size_t zeros = 0;
+            size_t length = 0;
+            if (!ReadVarint(in, end, zeros) || !ReadVarint(in, end, length))
+                return false;
+            if (zeros > size - pos || length > size - pos - zeros || length > (size_t)(end - in))
+                return false;
+
+            pos += zeros;
+            for (size_t i = 0; i < length; ++i)
+                data[pos + i] ^= in[i];
+            onChange(pos, length);
+
+            in += length;
+            pos += length;
+        }
+
+        return true;
+    }
+}
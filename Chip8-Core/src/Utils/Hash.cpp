@@ -0,0 +1,33 @@
+#include "Hash.h"
+
+#include <array>
+
+namespace
+{
+    constexpr std::array<uint32_t, 256> MakeCrc32Table()
+    {
+        std::array<uint32_t, 256> table = {};
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t crc = i;
+            for (uint32_t bit = 0; bit < 8; ++bit)
+                crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+            table[i] = crc;
+        }
+        return table;
+    }
+
+    constexpr std::array<uint32_t, 256> Crc32Table = MakeCrc32Table();
+}
+
+namespace Hash
+{
+    uint32_t Crc32(const void* const data, const size_t size)
+    {
+        const uint8_t* const bytes = (const uint8_t*)data;
+        uint32_t crc = ~0u;
+        for (size_t i = 0; i < size; ++i)
+            crc = Crc32Table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+}
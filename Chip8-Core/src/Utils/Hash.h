@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Hash
+{
+    // FNV-1a, for telling buffers apart. Passing the hash of one buffer in as the hash to start
+    // from hashes the next one as if they were joined.
+    inline uint64_t Fnv1a(const void* const data, const size_t size, uint64_t hash = 0xCBF29CE484222325ull)
+    {
+        const uint8_t* const bytes = (const uint8_t*)data;
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 0x100000001B3ull;
+        }
+        return hash;
+    }
+
+    // CRC-32 as in zip and PNG, for catching damaged files
+    uint32_t Crc32(const void* const data, const size_t size);
+}
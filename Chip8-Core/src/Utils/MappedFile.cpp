@@ -0,0 +1,109 @@
+#include "MappedFile.h"
+
+#include "Log.h"
+
+#ifdef _WIN32
+#   include <Windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const std::filesystem::path& filepath, const size_t size)
+{
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileW(filepath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+        OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        LOG_ERROR("Failed to open {}", filepath.string());
+        return false;
+    }
+
+    // The mapping grows the file to its size, filling the new part with zeros
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, nullptr);
+    void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size) : nullptr;
+    if (!data)
+    {
+        LOG_ERROR("Failed to map {0} bytes of {1}", size, filepath.string());
+        if (mapping)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    mFile = file;
+    mMapping = mapping;
+#else
+    const int file = open(filepath.c_str(), O_RDWR | O_CREAT, 0644);
+    if (file < 0)
+    {
+        LOG_ERROR("Failed to open {}", filepath.string());
+        return false;
+    }
+
+    struct stat info = {};
+    void* data = MAP_FAILED;
+    if (fstat(file, &info) == 0 && ((size_t)info.st_size >= size || ftruncate(file, (off_t)size) == 0))
+        data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if (data == MAP_FAILED)
+    {
+        LOG_ERROR("Failed to map {0} bytes of {1}", size, filepath.string());
+        close(file);
+        return false;
+    }
+
+    mFile = file;
+#endif
+
+    mData = (uint8_t*)data;
+    mSize = size;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (!mData)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(mData);
+    CloseHandle(mMapping);
+    CloseHandle(mFile);
+    mMapping = nullptr;
+    mFile = nullptr;
+#else
+    munmap(mData, mSize);
+    close(mFile);
+    mFile = -1;
+#endif
+
+    mData = nullptr;
+    mSize = 0;
+}
+
+void MappedFile::Sync(const size_t offset, const size_t size, const bool wait)
+{
+    if (!mData || size == 0)
+        return;
+
+#ifdef _WIN32
+    FlushViewOfFile(mData + offset, size);
+    if (wait)
+        FlushFileBuffers(mFile);
+#else
+    // msync wants a page aligned start
+    const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t begin = offset / pageSize * pageSize;
+    msync(mData + begin, offset + size - begin, wait ? MS_SYNC : MS_ASYNC);
+#endif
+}
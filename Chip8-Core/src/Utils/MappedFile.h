@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Types.h"
+
+#include <cstddef>
+#include <filesystem>
+
+// A file of fixed size mapped into memory for reading and writing. Writes to the mapping reach
+// the file whenever the OS writes the pages back, or when Sync asks for it.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Maps the first size bytes of the file, creating it or growing it with zeros if it's shorter
+    bool Open(const std::filesystem::path& filepath, const size_t size);
+    void Close();
+
+    // Starts writing back the pages overlapping the range, and waits for them to reach the disk
+    // if wait is set
+    void Sync(const size_t offset, const size_t size, const bool wait);
+
+    uint8_t* GetData() const { return mData; }
+    size_t GetSize() const { return mSize; }
+    bool IsOpen() const { return mData != nullptr; }
+
+private:
+    uint8_t* mData = nullptr;
+    size_t mSize = 0;
+
+#ifdef _WIN32
+    void* mFile = nullptr;
+    void* mMapping = nullptr;
+#else
+    int mFile = -1;
+#endif
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/*
+ * Hands the latest value from one producer thread to one consumer thread without locks.
+ *
+ * Each side owns one of three buffers and the third is shared. Publishing swaps the written
+ * buffer with the shared one and marks it fresh; the consumer swaps its buffer for the shared one
+ * only when it's fresh. Neither side ever waits, and a consumer that falls behind simply skips
+ * to the newest value. The producer gets back whichever buffer was shared, so it has to write
+ * a whole value every time rather than patch the previous one.
+ */
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Producer side
+    T& GetWriteBuffer() { return mBuffers[mWrite]; }
+    void Publish()
+    {
+        mWrite = mShared.exchange(mWrite | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Consumer side. Returns whether a newer value was picked up.
+    bool Update()
+    {
+        if ((mShared.load(std::memory_order_relaxed) & FRESH_BIT) == 0)
+            return false;
+
+        mRead = mShared.exchange(mRead, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+    const T& GetReadBuffer() const { return mBuffers[mRead]; }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t FRESH_BIT = 0x4;
+
+    std::array<T, 3> mBuffers;
+    uint8_t mWrite = 0;
+    uint8_t mRead = 1;
+    std::atomic<uint8_t> mShared = 2;
+};
@@ -4,6 +4,7 @@ project "Chip8-Emulator"
     language "C++"
     cppdialect "C++17"
     staticruntime "off"
+    removeplatforms { "Linux64" }
 
     targetdir (outputTargetDir)
     objdir (outputObjDir)
@@ -15,6 +16,7 @@ project "Chip8-Emulator"
 
     includedirs {
         "src",
+        "%{IncludeDir.Chip8Core}",
         "%{IncludeDir.Spdlog}",
         "%{IncludeDir.glfw}",
         "%{IncludeDir.glad}",
@@ -25,7 +27,8 @@ project "Chip8-Emulator"
         "%{Library.glfw}",
         "%{Library.glad}",
         "opengl32.lib",
-        "ImGui"
+        "ImGui",
+        "Chip8-Core"
     }
 
     defines { "GLFW_INCLUDE_NONE" }
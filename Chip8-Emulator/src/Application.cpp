@@ -4,6 +4,7 @@
 #include "Utils/FileUtils.h"
 #include "ImGuiWindows/Chip8InfoWindow.h"
 #include "ImGuiWindows/OpcodeLogWindow.h"
+#include "ImGuiWindows/ProfilerWindow.h"
 
 #include <GLFW/glfw3.h>
 #include <glad/glad.h>
@@ -16,6 +17,16 @@
 #include <array>
 
 constexpr char* LoadGameFileDialogKey = "LoadGame";
+constexpr char* PlayMovieFileDialogKey = "PlayMovie";
+constexpr char* MoviesDirectory = "Resources/Movies";
+
+// The left side of a QWERTY keyboard laid out like the COSMAC VIP keypad, indexed by Chip8 key
+constexpr std::array<int, 16> DefaultKeyBindings = {
+    GLFW_KEY_X, GLFW_KEY_1, GLFW_KEY_2, GLFW_KEY_3,
+    GLFW_KEY_Q, GLFW_KEY_W, GLFW_KEY_E, GLFW_KEY_A,
+    GLFW_KEY_S, GLFW_KEY_D, GLFW_KEY_Z, GLFW_KEY_C,
+    GLFW_KEY_4, GLFW_KEY_R, GLFW_KEY_F, GLFW_KEY_V
+};
 
 struct Vertex
 {
@@ -72,15 +83,41 @@ bool Application::Init()
         app.KeyCallback(key, scancode, action, mods);
     });
 
+    // Replaces ImGui's, so it's passed on
+    glfwSetWindowFocusCallback(mWindow, [](GLFWwindow* window, int focused) {
+        ImGui_ImplGlfw_WindowFocusCallback(window, focused);
+        Application& app = *(Application*)glfwGetWindowUserPointer(window);
+        app.WindowFocusCallback(focused);
+    });
+
+    mKeyBindings = DefaultKeyBindings;
+
+    mEmulation = CreateScope<EmulationThread>(mChip8);
+
     mMemoryEditor.Open = false;
     mMemoryEditor.OptShowDataPreview = true;
+    // The editors are handed the Application so they read the last snapshot and post edits
+    // through WriteMemory, which invalidates any cached code they overwrite
+    mMemoryEditor.ReadFn = [](const ImU8* data, size_t off) {
+        return ((const Application*)data)->mEmulation->GetSnapshot().memory[off];
+    };
+    mMemoryEditor.WriteFn = [](ImU8* data, size_t off, ImU8 d) {
+        ((Application*)data)->mEmulation->Post([off, d](Chip8& chip8) {
+            chip8.WriteMemory((uint16_t)off, d);
+        });
+    };
 
     mVramEditor.Open = false;
     mVramEditor.OptShowDataPreview = true;
-
-    mChip8.SetUpdateInputFunc(std::bind(&Application::UpdateInput, this, std::placeholders::_1));
-    mChip8.SetRenderFunc(std::bind(&Application::DrawChip8, this, std::placeholders::_1));
-    mChip8.SetOpcodeLogFunc(std::bind(&Application::AddOpcodeLogLine, this, std::placeholders::_1));
+    // VRAM is packed into words, so the editor shows it a byte at a time
+    mVramEditor.ReadFn = [](const ImU8* data, size_t off) {
+        return ((const Application*)data)->mEmulation->GetSnapshot().vram[off];
+    };
+    mVramEditor.WriteFn = [](ImU8* data, size_t off, ImU8 d) {
+        ((Application*)data)->mEmulation->Post([off, d](Chip8& chip8) {
+            chip8.WriteVram((uint32_t)off, d);
+        });
+    };
 
     mFrameBuffer.Bind();
     glClear(GL_COLOR_BUFFER_BIT);
@@ -92,9 +129,13 @@ bool Application::Init()
     mImGuiWindows.push_back(opcodeLogWin);
 
     auto chip8InfoWin = CreateRef<Chip8InfoWindow>();
-    chip8InfoWin->SetChip8(&mChip8);
+    chip8InfoWin->SetEmulation(mEmulation.get());
     mImGuiWindows.push_back(chip8InfoWin);
 
+    auto profilerWin = CreateRef<ProfilerWindow>();
+    profilerWin->SetEmulation(mEmulation.get());
+    mImGuiWindows.push_back(profilerWin);
+
     LoadEmulatorSettings();
 
     return true;
@@ -102,7 +143,11 @@ bool Application::Init()
 
 void Application::Shutdown()
 {
-    SaveEmulatorSettings();
+    if (mEmulation)
+    {
+        SaveEmulatorSettings();
+        mEmulation.reset();
+    }
 
     if (mImGuiInitialized)
     {
@@ -148,7 +193,11 @@ void Application::Run()
 {
     while (!glfwWindowShouldClose(mWindow))
     {
-        mChip8.Emulate();
+        UpdateOpcodeLogging();
+        UpdateProfiling();
+
+        if (mEmulation->Update())
+            DrawChip8(mEmulation->GetFrame());
 
         ImGuiBeginFrame();
 
@@ -158,85 +207,119 @@ void Application::Run()
 
         glfwSwapBuffers(mWindow);
 
-        glfwPollEvents();
+        // A game parked on FX0A only needs the loop for a key press or the next timer tick, so
+        // it sleeps until either instead of spinning
+        if (!mEmulation->IsThreaded() && mEmulation->GetSnapshot().waitingForKey)
+            glfwWaitEventsTimeout(1.0 / Chip8::TIMER_RATE);
+        else
+            glfwPollEvents();
     }
 }
 
-void Application::UpdateInput(std::array<uint8_t, 16>& keys)
-{
-    keys[0x1] = (glfwGetKey(mWindow, GLFW_KEY_1) == GLFW_PRESS) ? 1 : 0;
-    keys[0x2] = (glfwGetKey(mWindow, GLFW_KEY_2) == GLFW_PRESS) ? 1 : 0;
-    keys[0x3] = (glfwGetKey(mWindow, GLFW_KEY_3) == GLFW_PRESS) ? 1 : 0;
-    keys[0xC] = (glfwGetKey(mWindow, GLFW_KEY_4) == GLFW_PRESS) ? 1 : 0;
-
-    keys[0x4] = (glfwGetKey(mWindow, GLFW_KEY_Q) == GLFW_PRESS) ? 1 : 0;
-    keys[0x5] = (glfwGetKey(mWindow, GLFW_KEY_W) == GLFW_PRESS) ? 1 : 0;
-    keys[0x6] = (glfwGetKey(mWindow, GLFW_KEY_E) == GLFW_PRESS) ? 1 : 0;
-    keys[0xD] = (glfwGetKey(mWindow, GLFW_KEY_R) == GLFW_PRESS) ? 1 : 0;
-
-    keys[0x7] = (glfwGetKey(mWindow, GLFW_KEY_A) == GLFW_PRESS) ? 1 : 0;
-    keys[0x8] = (glfwGetKey(mWindow, GLFW_KEY_S) == GLFW_PRESS) ? 1 : 0;
-    keys[0x9] = (glfwGetKey(mWindow, GLFW_KEY_D) == GLFW_PRESS) ? 1 : 0;
-    keys[0xE] = (glfwGetKey(mWindow, GLFW_KEY_F) == GLFW_PRESS) ? 1 : 0;
-
-    keys[0xA] = (glfwGetKey(mWindow, GLFW_KEY_Z) == GLFW_PRESS) ? 1 : 0;
-    keys[0x0] = (glfwGetKey(mWindow, GLFW_KEY_X) == GLFW_PRESS) ? 1 : 0;
-    keys[0xB] = (glfwGetKey(mWindow, GLFW_KEY_C) == GLFW_PRESS) ? 1 : 0;
-    keys[0xF] = (glfwGetKey(mWindow, GLFW_KEY_V) == GLFW_PRESS) ? 1 : 0;
-}
-
 void Application::KeyCallback(int key, int scancode, int action, int mods)
 {
+    // Only presses and releases change the keys, so they're pushed from here rather than polled.
+    // The emulation side reads them at its own input samples.
+    if (action == GLFW_PRESS || action == GLFW_RELEASE)
+    {
+        uint16_t keyMask = mKeyMask;
+        for (uint32_t i = 0; i < std::size(mKeyBindings); ++i)
+        {
+            if (mKeyBindings[i] != key)
+                continue;
+
+            if (action == GLFW_PRESS)
+                keyMask |= (uint16_t)(1 << i);
+            else
+                keyMask &= (uint16_t)~(1 << i);
+        }
+
+        if (keyMask != mKeyMask)
+        {
+            mKeyMask = keyMask;
+            mEmulation->PushKeys(mKeyMask);
+        }
+    }
+
+    if (key == GLFW_KEY_BACKSPACE)
+    {
+        if (action == GLFW_PRESS && !ImGui::GetIO().WantCaptureKeyboard)
+            mEmulation->SetRewinding(true);
+        else if (action == GLFW_RELEASE)
+            mEmulation->SetRewinding(false);
+    }
+
     if (action == GLFW_RELEASE)
     {
-        if (key == GLFW_KEY_O && mods == GLFW_MOD_CONTROL)
+        // Tab also moves between widgets while one has focus
+        if (key == GLFW_KEY_TAB && mods == 0 && !ImGui::GetIO().WantCaptureKeyboard)
+        {
+            EmulationThread::Settings settings = mEmulation->GetSettings();
+            settings.turbo = !settings.turbo;
+            mEmulation->SetSettings(settings);
+        }
+        else if (key == GLFW_KEY_O && mods == GLFW_MOD_CONTROL)
             LoadGame();
         else if (mods == GLFW_MOD_SHIFT)
         {
             if (key == GLFW_KEY_F1)
-                mChip8.SaveState(1);
+                SaveState(1);
             else if (key == GLFW_KEY_F2)
-                mChip8.SaveState(2);
+                SaveState(2);
             else if (key == GLFW_KEY_F3)
-                mChip8.SaveState(3);
+                SaveState(3);
             else if (key == GLFW_KEY_F4)
-                mChip8.SaveState(4);
+                SaveState(4);
             else if (key == GLFW_KEY_F5)
-                mChip8.SaveState(5);
+                SaveState(5);
             else if (key == GLFW_KEY_F6)
-                mChip8.SaveState(6);
+                SaveState(6);
             else if (key == GLFW_KEY_F7)
-                mChip8.SaveState(7);
+                SaveState(7);
             else if (key == GLFW_KEY_F8)
-                mChip8.SaveState(8);
+                SaveState(8);
             else if (key == GLFW_KEY_F9)
-                mChip8.SaveState(9);
+                SaveState(9);
             else if (key == GLFW_KEY_F10)
-                mChip8.SaveState(10);
+                SaveState(10);
         }
         else if (key == GLFW_KEY_F1)
-            mChip8.LoadState(1);
+            LoadState(1);
         else if (key == GLFW_KEY_F2)
-            mChip8.LoadState(2);
+            LoadState(2);
         else if (key == GLFW_KEY_F3)
-            mChip8.LoadState(3);
+            LoadState(3);
         else if (key == GLFW_KEY_F4)
-            mChip8.LoadState(4);
+            LoadState(4);
         else if (key == GLFW_KEY_F5)
-            mChip8.LoadState(5);
+            LoadState(5);
         else if (key == GLFW_KEY_F6)
-            mChip8.LoadState(6);
+            LoadState(6);
         else if (key == GLFW_KEY_F7)
-            mChip8.LoadState(7);
+            LoadState(7);
         else if (key == GLFW_KEY_F8)
-            mChip8.LoadState(8);
+            LoadState(8);
         else if (key == GLFW_KEY_F9)
-            mChip8.LoadState(9);
+            LoadState(9);
         else if (key == GLFW_KEY_F10)
-            mChip8.LoadState(10);
+            LoadState(10);
     }
 }
 
+void Application::WindowFocusCallback(int focused)
+{
+    // Releases aren't sent to an unfocused window, so nothing is left held down
+    if (focused)
+        return;
+
+    if (mKeyMask != 0)
+    {
+        mKeyMask = 0;
+        mEmulation->PushKeys(mKeyMask);
+    }
+    mEmulation->SetRewinding(false);
+}
+
 void Application::ErrorCallback(int error, const char* description)
 {
     LOG_ERROR("GLFW ERROR ({0}): {1}", error, description);
@@ -401,10 +484,10 @@ void Application::ImGuiRender()
         ImGui::ShowMetricsWindow(&mIsMetricsWindowOpen);
 
     if (mMemoryEditor.Open)
-        mMemoryEditor.DrawWindow("Memory", std::data(mChip8.GetMemory()), std::size(mChip8.GetMemory()));
+        mMemoryEditor.DrawWindow("Memory", (ImU8*)this, Chip8::MEM_SIZE);
 
     if (mVramEditor.Open)
-        mVramEditor.DrawWindow("VRAM", std::data(mChip8.GetVram()), std::size(mChip8.GetVram()));
+        mVramEditor.DrawWindow("VRAM", (ImU8*)this, mEmulation->GetSnapshot().vramSize);
 
     for (auto& imGuiWin : mImGuiWindows)
         imGuiWin->Render();
@@ -414,15 +497,31 @@ void Application::ImGuiRender()
     ImGui::End();
 }
 
-void Application::DrawChip8(const std::vector<uint32_t>& vram)
+void Application::DrawChip8(const EmulationThread::Frame& frame)
 {
+    const uint32_t width = frame.width;
+    const uint32_t height = frame.height;
+
+    // Games can switch between 64x32 and 128x64 while running
+    if (mTexture.GetWidth() != width || mTexture.GetHeight() != height)
+    {
+        mTexture.Destroy();
+        mTexture.Create(width, height);
+        mFrameBuffer.Resize(width, height);
+    }
+
     mFrameBuffer.Bind();
     glClear(GL_COLOR_BUFFER_BIT);
-    glBindVertexArray(mVAO);
 
-    mTexture.Update(mChip8.GetScreenWidth(), mChip8.GetScreenHeight(), (const char*)std::data(vram));
+    if (!std::empty(frame.pixels))
+    {
+        glBindVertexArray(mVAO);
+
+        mTexture.Update(width, height, (const char*)std::data(frame.pixels));
+
+        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, nullptr);
+    }
 
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, nullptr);
     mFrameBuffer.Unbind();
 }
 
@@ -435,66 +534,80 @@ void Application::ImGuiMainMenuRender()
             if (ImGui::MenuItem("Load Game", "Ctrl+O"))
                 LoadGame();
             ImGui::Separator();
-            if (ImGui::BeginMenu("Save State", !std::empty(mChip8.GetGameFile())))
+            if (ImGui::BeginMenu("Save State", mEmulation->GetSnapshot().hasGame))
             {
                 if (ImGui::MenuItem("State 1", "Shift+F1"))
-                    mChip8.SaveState(1);
+                    SaveState(1);
                 else if (ImGui::MenuItem("State 2", "Shift+F2"))
-                    mChip8.SaveState(2);
+                    SaveState(2);
                 else if (ImGui::MenuItem("State 3", "Shift+F3"))
-                    mChip8.SaveState(3);
+                    SaveState(3);
                 else if (ImGui::MenuItem("State 4", "Shift+F4"))
-                    mChip8.SaveState(4);
+                    SaveState(4);
                 else if (ImGui::MenuItem("State 5", "Shift+F5"))
-                    mChip8.SaveState(5);
+                    SaveState(5);
                 else if (ImGui::MenuItem("State 6", "Shift+F6"))
-                    mChip8.SaveState(6);
+                    SaveState(6);
                 else if (ImGui::MenuItem("State 7", "Shift+F7"))
-                    mChip8.SaveState(7);
+                    SaveState(7);
                 else if (ImGui::MenuItem("State 8", "Shift+F8"))
-                    mChip8.SaveState(8);
+                    SaveState(8);
                 else if (ImGui::MenuItem("State 9", "Shift+F9"))
-                    mChip8.SaveState(9);
+                    SaveState(9);
                 else if (ImGui::MenuItem("State 10", "Shift+F10"))
-                    mChip8.SaveState(10);
+                    SaveState(10);
 
                 ImGui::EndMenu();
             }
-            if (ImGui::BeginMenu("Load State", !std::empty(mChip8.GetGameFile())))
+            if (ImGui::BeginMenu("Load State", mEmulation->GetSnapshot().hasGame))
             {
                 if (ImGui::MenuItem("State 1", "F1"))
-                    mChip8.LoadState(1);
+                    LoadState(1);
                 else if (ImGui::MenuItem("State 2", "F2"))
-                    mChip8.LoadState(2);
+                    LoadState(2);
                 else if (ImGui::MenuItem("State 3", "F3"))
-                    mChip8.LoadState(3);
+                    LoadState(3);
                 else if (ImGui::MenuItem("State 4", "F4"))
-                    mChip8.LoadState(4);
+                    LoadState(4);
                 else if (ImGui::MenuItem("State 5", "F5"))
-                    mChip8.LoadState(5);
+                    LoadState(5);
                 else if (ImGui::MenuItem("State 6", "F6"))
-                    mChip8.LoadState(6);
+                    LoadState(6);
                 else if (ImGui::MenuItem("State 7", "F7"))
-                    mChip8.LoadState(7);
+                    LoadState(7);
                 else if (ImGui::MenuItem("State 8", "F8"))
-                    mChip8.LoadState(8);
+                    LoadState(8);
                 else if (ImGui::MenuItem("State 9", "F9"))
-                    mChip8.LoadState(9);
+                    LoadState(9);
                 else if (ImGui::MenuItem("State 10", "F10"))
-                    mChip8.LoadState(10);
+                    LoadState(10);
+
+                ImGui::EndMenu();
+            }
+
+            if (ImGui::BeginMenu("Movie", mEmulation->GetSnapshot().hasGame))
+            {
+                const bool movieActive = mEmulation->GetSnapshot().movieMode != Movie::Mode::eIdle;
+                if (ImGui::MenuItem("Record", nullptr, nullptr, !movieActive))
+                    mEmulation->StartRecording(MoviesDirectory);
+                else if (ImGui::MenuItem("Play", nullptr, nullptr, !movieActive))
+                    PlayMovie();
+                else if (ImGui::MenuItem("Stop", nullptr, nullptr, movieActive))
+                    mEmulation->StopMovie();
 
                 ImGui::EndMenu();
             }
 
             ImGui::Separator();
-            if (ImGui::MenuItem("Disassemble", nullptr, nullptr, !std::empty(mChip8.GetGameFile())))
+            if (ImGui::MenuItem("Disassemble", nullptr, nullptr, mEmulation->GetSnapshot().hasGame))
             {
-                auto text = mChip8.Disassemble();
-                FileUtils::WriteText("Resources/TestOpCodes.txt", text);
+                mEmulation->Post([](Chip8& chip8) {
+                    FileUtils::WriteText("Resources/TestOpCodes.txt", chip8.Disassemble());
+                });
             }
 
             ImGui::Separator();
-            if (ImGui::MenuItem("Exit Game", nullptr, nullptr, !std::empty(mChip8.GetGameFile())))
+            if (ImGui::MenuItem("Exit Game", nullptr, nullptr, mEmulation->GetSnapshot().hasGame))
                 ExitGame();
 
             ImGui::EndMenu();
@@ -545,11 +658,22 @@ void Application::RenderDialogs()
         if (ImGuiFileDialog::Instance()->IsOk())
         {
             const std::filesystem::path file = ImGuiFileDialog::Instance()->GetFilePathName();
-            mChip8.LoadGame(file);
+            mEmulation->StopMovie();
+            mEmulation->Post([file](Chip8& chip8) {
+                chip8.LoadGame(file);
+            });
         }
 
         ImGuiFileDialog::Instance()->Close();
     }
+
+    if (ImGuiFileDialog::Instance()->Display(PlayMovieFileDialogKey, ImGuiWindowFlags_NoCollapse, ImVec2(600.0f, 400.0f)))
+    {
+        if (ImGuiFileDialog::Instance()->IsOk())
+            mEmulation->StartPlayback(ImGuiFileDialog::Instance()->GetFilePathName());
+
+        ImGuiFileDialog::Instance()->Close();
+    }
 }
 
 void Application::LoadGame()
@@ -566,6 +690,9 @@ void Application::LoadEmulatorSettings()
         return;
     }
 
+    EmulationThread::Settings settings = mEmulation->GetSettings();
+    bool threaded = false;
+
     std::string line;
     while (std::getline(file, line))
     {
@@ -582,11 +709,37 @@ void Application::LoadEmulatorSettings()
         else if (key == "vramWindowOpen")
             mVramEditor.Open = (bool)std::stoi(value);
         else if (key == "emuSpeedModifier")
-            mChip8.SetEmuSpeedModifier((uint8_t)std::stoi(value));
+            settings.emuSpeedModifier = (uint8_t)std::stoi(value);
+        else if (key == "instructionsPerSecond")
+            settings.instructionsPerSecond = (uint32_t)std::stoul(value);
         else if (key == "drawnColor")
-            mChip8.SetDrawnColor((uint32_t)std::stoul(value));
+            settings.drawnColor = (uint32_t)std::stoul(value);
         else if (key == "undrawnColor")
-            mChip8.SetUndrawnColor((uint32_t)std::stoul(value));
+            settings.undrawnColor = (uint32_t)std::stoul(value);
+        else if (key == "backend")
+            settings.backend = (Chip8::Backend)std::stoul(value);
+        else if (key == "jitLockstep")
+            settings.jitLockstep = (bool)std::stoi(value);
+        else if (key == "coalesceFrames")
+            settings.coalesceFrames = (bool)std::stoi(value);
+        else if (key == "idleSkipping")
+            settings.idleSkipping = (bool)std::stoi(value);
+        else if (key == "rewindBudgetMiB")
+            settings.rewindBudgetMiB = (uint32_t)std::stoul(value);
+        else if (key == "inputSamplesPerTick")
+            settings.inputSamplesPerTick = (uint32_t)std::stoul(value);
+        else if (key == "runAheadFrames")
+            settings.runAheadFrames = (uint32_t)std::stoul(value);
+        else if (key == "saveSync")
+            settings.saveSync = (Chip8::SaveSync)std::stoul(value);
+        else if (key.rfind("keyBinding", 0) == 0)
+        {
+            const uint32_t chip8Key = (uint32_t)std::stoul(key.substr(std::size("keyBinding") - 1));
+            if (chip8Key < std::size(mKeyBindings))
+                mKeyBindings[chip8Key] = std::stoi(value);
+        }
+        else if (key == "threadedEmulation")
+            threaded = (bool)std::stoi(value);
         else if (key == "theme")
         {
             mTheme = (Theme)std::stoul(value);
@@ -604,6 +757,9 @@ void Application::LoadEmulatorSettings()
             }
         }
     }
+
+    mEmulation->SetSettings(settings);
+    mEmulation->SetThreaded(threaded);
 }
 
 void Application::SaveEmulatorSettings()
@@ -623,24 +779,88 @@ void Application::SaveEmulatorSettings()
     for (auto& win : mImGuiWindows)
         file << win->GetSaveId() << "=" << win->IsOpen() << std::endl;
 
-    file << "emuSpeedModifier=" << (uint32_t)mChip8.GetEmuSpeedModifier() << std::endl;
-    file << "drawnColor=" << mChip8.GetDrawnColor() << std::endl;
-    file << "undrawnColor=" << mChip8.GetUndrawnColor() << std::endl;
+    const EmulationThread::Settings& settings = mEmulation->GetSettings();
+    file << "emuSpeedModifier=" << (uint32_t)settings.emuSpeedModifier << std::endl;
+    file << "instructionsPerSecond=" << settings.instructionsPerSecond << std::endl;
+    file << "drawnColor=" << settings.drawnColor << std::endl;
+    file << "undrawnColor=" << settings.undrawnColor << std::endl;
+    file << "backend=" << (uint32_t)settings.backend << std::endl;
+    file << "jitLockstep=" << settings.jitLockstep << std::endl;
+    file << "coalesceFrames=" << settings.coalesceFrames << std::endl;
+    file << "idleSkipping=" << settings.idleSkipping << std::endl;
+    file << "inputSamplesPerTick=" << settings.inputSamplesPerTick << std::endl;
+    file << "runAheadFrames=" << settings.runAheadFrames << std::endl;
+    file << "rewindBudgetMiB=" << settings.rewindBudgetMiB << std::endl;
+    file << "saveSync=" << (uint32_t)settings.saveSync << std::endl;
+    for (uint32_t i = 0; i < std::size(mKeyBindings); ++i)
+        file << "keyBinding" << i << "=" << mKeyBindings[i] << std::endl;
+    file << "threadedEmulation=" << mEmulation->IsThreaded() << std::endl;
+}
+
+void Application::UpdateOpcodeLogging()
+{
+    // Formatting log lines is expensive and keeps the JIT from running, so lines are only
+    // produced while the window showing them is open
+    auto win = GetImGuiWindow<OpcodeLogWindow>();
+    const bool logOpcodes = win->IsOpen();
+    if (logOpcodes != mLogOpcodes)
+    {
+        mLogOpcodes = logOpcodes;
+        mEmulation->SetLogOpcodes(mLogOpcodes);
+    }
+
+    // Lines already queued when the window closed are still drained so they don't show up the
+    // next time it opens
+    std::string line;
+    while (mEmulation->PopLogLine(line))
+    {
+        if (mLogOpcodes)
+            win->AddLine(line);
+    }
 }
 
-void Application::AddOpcodeLogLine(const std::string& line)
+void Application::UpdateProfiling()
 {
-    if (auto win = GetImGuiWindow<OpcodeLogWindow>(); win->IsOpen())
-        win->AddLine(line);
+    const bool profiling = GetImGuiWindow<ProfilerWindow>()->IsOpen();
+    if (profiling != mProfiling)
+    {
+        mProfiling = profiling;
+        mEmulation->SetProfiling(mProfiling);
+    }
 }
 
-void Application::ExitGame()
+void Application::SaveState(const uint32_t slot)
 {
-    mChip8.CloseGame();
+    mEmulation->Post([slot](Chip8& chip8) {
+        chip8.SaveState(slot);
+    });
+}
 
-    mFrameBuffer.Bind();
-    glClear(GL_COLOR_BUFFER_BIT);
-    mFrameBuffer.Unbind();
+void Application::LoadState(const uint32_t slot)
+{
+    // A movie can't follow the game to another point in time
+    mEmulation->StopMovie();
+    mEmulation->Post([slot](Chip8& chip8) {
+        chip8.LoadState(slot);
+    });
+}
+
+void Application::PlayMovie()
+{
+    ImGuiFileDialog::Instance()->OpenDialog(PlayMovieFileDialogKey, "Play Movie", "Chip8 Movies (*.c8movie){.c8movie}", MoviesDirectory);
+}
+
+void Application::ExitGame()
+{
+    mEmulation->StopMovie();
+
+    // The emulation side clears the screen too, so a frame already on its way can't be drawn
+    // over the cleared one
+    EmulationThread* emulation = mEmulation.get();
+    emulation->Post([emulation](Chip8& chip8) {
+        chip8.CloseGame();
+        emulation->ClearFrame();
+    });
 }
 
 template <typename T>
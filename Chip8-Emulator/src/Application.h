@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Chip8.h"
+#include "EmulationThread.h"
 #include "Types.h"
 #include "OpenGL/OpenGLShader.h"
 #include "OpenGL/OpenGLFramebuffer.h"
@@ -9,6 +10,7 @@
 #include <imgui.h>
 #include <imgui_memory_editor.h>
 
+#include <array>
 #include <vector>
 #include <string>
 #include <filesystem>
@@ -28,6 +30,7 @@ public:
     void Run();
 
     void KeyCallback(int key, int scancode, int action, int mods);
+    void WindowFocusCallback(int focused);
 
 private:
     static void ErrorCallback(int error, const char* description);
@@ -44,16 +47,19 @@ private:
     void ImGuiMainMenuRender();
     void RenderDialogs();
 
-    void UpdateInput(std::array<uint8_t, 16>& keys);
-    void DrawChip8(const std::vector<uint32_t>& vram);
+    void DrawChip8(const EmulationThread::Frame& frame);
 
     void LoadGame();
 
     void LoadEmulatorSettings();
     void SaveEmulatorSettings();
 
-    void AddOpcodeLogLine(const std::string& line);
+    void UpdateOpcodeLogging();
+    void UpdateProfiling();
 
+    void SaveState(const uint32_t slot);
+    void LoadState(const uint32_t slot);
+    void PlayMovie();
     void ExitGame();
 
     template <typename T>
@@ -68,6 +74,8 @@ private:
 
 private:
     Chip8 mChip8;
+    // Everything the UI does with the Chip8 goes through here
+    Scope<EmulationThread> mEmulation;
     GLFWwindow* mWindow = nullptr;
     uint32_t mVAO = 0;
     uint32_t mVertexBuffer = 0;
@@ -83,6 +91,13 @@ private:
 
     Theme mTheme = Theme::Dark;
 
+    // The GLFW key for each Chip8 key, and the Chip8 keys currently held, kept up to date by the
+    // key callback
+    std::array<int, 16> mKeyBindings = {};
+    uint16_t mKeyMask = 0;
+
     bool mImGuiInitialized = false;
     bool mIsMetricsWindowOpen = true;
+    bool mLogOpcodes = false;
+    bool mProfiling = false;
 };
@@ -0,0 +1,389 @@
+#include "EmulationThread.h"
+
+#include "Log.h"
+
+EmulationThread::EmulationThread(Chip8& chip8) :
+    mChip8(chip8),
+    mSettings(ReadSettings(chip8)),
+    mAppliedSettings(mSettings),
+    mLastFrameTime(std::chrono::steady_clock::now()),
+    mMipsWindowStart(mLastFrameTime)
+{
+    mChip8.SetUpdateInputFunc(std::bind(&EmulationThread::UpdateInput, this, std::placeholders::_1));
+    mChip8.SetRenderFunc(std::bind(&EmulationThread::PublishFrame, this, std::placeholders::_1));
+}
+
+EmulationThread::~EmulationThread()
+{
+    SetThreaded(false);
+
+    mChip8.SetUpdateInputFunc(nullptr);
+    mChip8.SetRenderFunc(nullptr);
+    mChip8.SetOpcodeLogFunc(nullptr);
+}
+
+void EmulationThread::SetThreaded(const bool threaded)
+{
+    if (threaded == IsThreaded())
+        return;
+
+    if (threaded)
+    {
+        mRunning = true;
+        mThread = std::thread(&EmulationThread::ThreadMain, this);
+    }
+    else
+    {
+        mRunning = false;
+        mThread.join();
+    }
+}
+
+bool EmulationThread::Update()
+{
+    if (!IsThreaded())
+        RunFrame();
+
+    mSnapshots.Update();
+    mProfiles.Update();
+    return mFrames.Update();
+}
+
+void EmulationThread::Post(Command command)
+{
+    if (!mCommands.Push(std::move(command)))
+        LOG_WARN("Emulation command queue is full, dropping command");
+}
+
+void EmulationThread::PushKeys(const uint16_t keys)
+{
+    // Only the newest keys matter, so a full queue just means the emulation side is behind
+    mKeys.Push(keys);
+
+    if (keys != mPushedKeys)
+    {
+        mPushedKeys = keys;
+        {
+            std::lock_guard<std::mutex> lock(mWakeMutex);
+            mKeysChanged = true;
+        }
+        mWakeCondition.notify_one();
+    }
+}
+
+void EmulationThread::SetRewinding(const bool rewinding)
+{
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mRewinding = rewinding;
+    }
+    mWakeCondition.notify_one();
+}
+
+void EmulationThread::StartRecording(const std::filesystem::path& directory)
+{
+    Post([this, directory](Chip8& chip8) {
+        FinishMovie();
+        if (!mMovie.StartRecording(chip8, true))
+            return;
+
+        mMovieFile = directory / chip8.GetGameFile().stem();
+        mMovieFile += ".c8movie";
+        mMovieTime = 0.0f;
+        mRewind.Clear();
+        LOG_INFO("Recording a movie to {}", mMovieFile.string());
+    });
+}
+
+void EmulationThread::StartPlayback(const std::filesystem::path& filepath)
+{
+    Post([this, filepath](Chip8& chip8) {
+        FinishMovie();
+        if (!mMovie.Load(filepath) || !mMovie.StartPlayback(chip8))
+            return;
+
+        mMovieFile = filepath;
+        mMovieTime = 0.0f;
+        mRewind.Clear();
+        LOG_INFO("Playing back {0}, {1} frames", filepath.string(), mMovie.GetNumFrames());
+    });
+}
+
+void EmulationThread::StopMovie()
+{
+    Post([this](Chip8&) {
+        FinishMovie();
+    });
+}
+
+void EmulationThread::SetSettings(const Settings& settings)
+{
+    // A new budget reallocates the history and drops it, so it's only passed on when it changed
+    const bool budgetChanged = settings.rewindBudgetMiB != mSettings.rewindBudgetMiB;
+    mSettings = settings;
+    Post([this, settings, budgetChanged](Chip8& chip8) {
+        ApplySettings(chip8, settings);
+        mAppliedSettings = settings;
+        if (budgetChanged)
+            mRewind.SetBudget((size_t)settings.rewindBudgetMiB * 1024 * 1024);
+    });
+}
+
+void EmulationThread::SetLogOpcodes(const bool logOpcodes)
+{
+    if (logOpcodes)
+    {
+        Post([this](Chip8& chip8) {
+            chip8.SetOpcodeLogFunc(std::bind(&EmulationThread::AddLogLine, this, std::placeholders::_1));
+        });
+    }
+    else
+    {
+        Post([](Chip8& chip8) {
+            chip8.SetOpcodeLogFunc(nullptr);
+        });
+    }
+}
+
+void EmulationThread::SetProfiling(const bool profiling)
+{
+    Post([profiling](Chip8& chip8) {
+        chip8.SetProfiling(profiling);
+    });
+}
+
+void EmulationThread::ClearFrame()
+{
+    Frame& frame = mFrames.GetWriteBuffer();
+    frame.pixels.clear();
+    frame.width = mChip8.GetScreenWidth();
+    frame.height = mChip8.GetScreenHeight();
+    mFrames.Publish();
+}
+
+void EmulationThread::ThreadMain()
+{
+    using Clock = std::chrono::steady_clock;
+
+    auto nextFrame = Clock::now();
+    while (mRunning)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mWakeMutex);
+            mKeysChanged = false;
+        }
+        RunFrame();
+
+        const auto frameTime = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(1.0 / mChip8.GetFrameRate()));
+        nextFrame += frameTime;
+
+        // Don't try to catch up after a stall, like a breakpoint or a slow save, just carry on
+        const auto now = Clock::now();
+        if (now - nextFrame > frameTime * 4)
+            nextFrame = now;
+
+        // A frame run early for a key press still leaves the next one on schedule
+        if (WaitUntil(nextFrame))
+            nextFrame -= frameTime;
+    }
+}
+
+bool EmulationThread::WaitUntil(const std::chrono::steady_clock::time_point time)
+{
+    std::unique_lock<std::mutex> lock(mWakeMutex);
+    if (!mChip8.IsWaitingForKey())
+    {
+        lock.unlock();
+        std::this_thread::sleep_until(time);
+        return false;
+    }
+
+    return mWakeCondition.wait_until(lock, time, [this] { return mKeysChanged || mRewinding; });
+}
+
+void EmulationThread::RunFrame()
+{
+    Command command;
+    while (mCommands.Pop(command))
+        command(mChip8);
+
+    const auto now = std::chrono::steady_clock::now();
+    if (mRewinding)
+    {
+        FinishMovie();
+        if (mRewind.StepBack(mChip8))
+            mChip8.PresentFrame();
+    }
+    else if (mMovie.IsActive())
+    {
+        RunMovieFrames(std::chrono::duration<float>(now - mLastFrameTime).count());
+        mRewind.Record(mChip8);
+    }
+    else
+    {
+        mChip8.Emulate(TimeStep(std::chrono::duration<float>(now - mLastFrameTime).count()));
+        mRewind.Record(mChip8);
+    }
+    mLastFrameTime = now;
+
+    MeasureMips();
+    PublishSnapshot();
+    if (mChip8.GetProfiling())
+        PublishProfile();
+}
+
+void EmulationThread::RunMovieFrames(const float seconds)
+{
+    mMovieTime = std::min(mMovieTime + seconds, Chip8::MAX_TIME_STEP);
+    const float frameTime = 1.0f / mChip8.GetFrameRate();
+    while (mMovieTime >= frameTime)
+    {
+        mMovieTime -= frameTime;
+
+        while (mKeys.Pop(mLatestKeys)) {}
+        if (!mMovie.RunFrame(mChip8, mLatestKeys))
+        {
+            FinishMovie();
+            break;
+        }
+    }
+}
+
+void EmulationThread::FinishMovie()
+{
+    if (!mMovie.IsActive())
+        return;
+
+    if (mMovie.GetMode() == Movie::Mode::eRecording)
+        mMovie.Save(mMovieFile);
+    else if (mMovie.GetDivergedFrame() == Movie::NO_FRAME)
+        LOG_INFO("Played back {0} frames of {1}", mMovie.GetFrame(), mMovieFile.string());
+    mMovie.Stop();
+
+    // The movie held the Chip8 to its own settings
+    ApplySettings(mChip8, mAppliedSettings);
+}
+
+void EmulationThread::UpdateInput(uint16_t& keys)
+{
+    while (mKeys.Pop(mLatestKeys)) {}
+
+    keys = mLatestKeys;
+}
+
+void EmulationThread::PublishFrame(const std::vector<uint32_t>& pixels)
+{
+    Frame& frame = mFrames.GetWriteBuffer();
+    frame.pixels = pixels;
+    frame.width = mChip8.GetScreenWidth();
+    frame.height = mChip8.GetScreenHeight();
+    mFrames.Publish();
+}
+
+void EmulationThread::PublishSnapshot()
+{
+    Snapshot& snapshot = mSnapshots.GetWriteBuffer();
+    snapshot.hasGame = !std::empty(mChip8.GetGameFile());
+    snapshot.waitingForKey = mChip8.IsWaitingForKey();
+    snapshot.opcode = mChip8.GetOpcode();
+    snapshot.indexReg = mChip8.GetIndexReg();
+    snapshot.pc = mChip8.GetProgramCounter();
+    snapshot.sp = mChip8.GetStackPointer();
+    snapshot.delayTimer = mChip8.GetDelayTimer();
+    snapshot.soundTimer = mChip8.GetSoundTimer();
+    snapshot.vramGeneration = mChip8.GetVramGeneration();
+    snapshot.mips = mMips;
+    snapshot.idleShare = mIdleShare;
+    snapshot.rewindStates = mRewind.GetNumStates();
+    snapshot.rewindBytes = mRewind.GetUsedBytes();
+    snapshot.movieMode = mMovie.GetMode();
+    snapshot.movieFrame = mMovie.GetFrame();
+    snapshot.movieFrames = mMovie.GetNumFrames();
+    snapshot.movieDivergedFrame = mMovie.GetDivergedFrame();
+    snapshot.v = mChip8.GetVReg();
+    snapshot.keys = mChip8.GetKeys();
+    snapshot.memory = mChip8.GetMemory();
+
+    snapshot.vramSize = mChip8.GetVramSize();
+    for (uint32_t i = 0; i < snapshot.vramSize; ++i)
+        snapshot.vram[i] = mChip8.ReadVram(i);
+
+    mSnapshots.Publish();
+}
+
+void EmulationThread::PublishProfile()
+{
+    mProfiles.GetWriteBuffer() = mChip8.GetProfile();
+    mProfiles.Publish();
+}
+
+void EmulationThread::MeasureMips()
+{
+    // Averaged over half a second so the number can be read while it's changing
+    constexpr std::chrono::milliseconds MipsWindow(500);
+
+    const uint64_t cycles = mChip8.GetTotalCycles();
+    const uint64_t idleCycles = mChip8.GetIdleCycles();
+    // The counts start over when a game is loaded or exits
+    if (cycles < mMipsWindowCycles)
+    {
+        mMipsWindowCycles = 0;
+        mMipsWindowIdleCycles = 0;
+    }
+
+    const auto elapsed = mLastFrameTime - mMipsWindowStart;
+    if (elapsed < MipsWindow)
+        return;
+
+    mMips = (cycles - mMipsWindowCycles) / std::chrono::duration<double, std::micro>(elapsed).count();
+    mIdleShare = (cycles > mMipsWindowCycles) ? (double)(idleCycles - mMipsWindowIdleCycles) / (cycles - mMipsWindowCycles) : 0.0;
+    mMipsWindowStart = mLastFrameTime;
+    mMipsWindowCycles = cycles;
+    mMipsWindowIdleCycles = idleCycles;
+}
+
+void EmulationThread::AddLogLine(const std::string& line)
+{
+    mLogLines.Push(line);
+}
+
+EmulationThread::Settings EmulationThread::ReadSettings(const Chip8& chip8)
+{
+    Settings settings;
+    settings.drawnColor = chip8.GetDrawnColor();
+    settings.undrawnColor = chip8.GetUndrawnColor();
+    settings.emuSpeedModifier = chip8.GetEmuSpeedModifier();
+    settings.instructionsPerSecond = chip8.GetInstructionsPerSecond();
+    settings.backend = chip8.GetBackend();
+    settings.jitLockstep = chip8.GetJitLockstep();
+    settings.coalesceFrames = chip8.GetCoalesceFrames();
+    settings.idleSkipping = chip8.GetIdleSkipping();
+    settings.inputSamplesPerTick = chip8.GetInputSamplesPerTick();
+    settings.runAheadFrames = chip8.GetRunAheadFrames();
+    settings.saveSync = chip8.GetSaveSync();
+    settings.useVYForShiftQuirk = chip8.GetUseVYForShiftQuirk();
+    settings.useBXNNQuirk = chip8.GetUseBXNNQuirk();
+    settings.useIndexIncrementAfterStoreLoadQuirk = chip8.GetUseIndexIncrementAfterStoreLoadQuirk();
+    settings.turbo = chip8.GetTurbo();
+    return settings;
+}
+
+void EmulationThread::ApplySettings(Chip8& chip8, const Settings& settings)
+{
+    chip8.SetDrawnColor(settings.drawnColor);
+    chip8.SetUndrawnColor(settings.undrawnColor);
+    chip8.SetEmuSpeedModifier(settings.emuSpeedModifier);
+    chip8.SetInstructionsPerSecond(settings.instructionsPerSecond);
+    chip8.SetBackend(settings.backend);
+    chip8.SetJitLockstep(settings.jitLockstep);
+    chip8.SetCoalesceFrames(settings.coalesceFrames);
+    chip8.SetIdleSkipping(settings.idleSkipping);
+    chip8.SetInputSamplesPerTick(settings.inputSamplesPerTick);
+    chip8.SetRunAheadFrames(settings.runAheadFrames);
+    chip8.SetSaveSync(settings.saveSync);
+    chip8.SetUseVYForShiftQuirk(settings.useVYForShiftQuirk);
+    chip8.SetUseBXNNQuirk(settings.useBXNNQuirk);
+    chip8.SetUseIndexIncrementAfterStoreLoadQuirk(settings.useIndexIncrementAfterStoreLoadQuirk);
+    chip8.SetTurbo(settings.turbo);
+}
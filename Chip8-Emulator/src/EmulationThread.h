@@ -0,0 +1,212 @@
+#pragma once
+
+#include "Chip8.h"
+#include "Movie.h"
+#include "RewindBuffer.h"
+#include "Utils/TripleBuffer.h"
+#include "Utils/SpscQueue.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Runs the Chip8 either on the UI thread or on a thread of its own.
+ *
+ * The UI never touches the Chip8 directly. Anything that changes it is posted as a command that
+ * runs between frames, keys go over in a queue, and finished frames, a snapshot of the state and
+ * opcode log lines come back through lock-free buffers. Both modes take the same path, so
+ * switching between them only changes which thread runs the frames and how they're paced: the
+ * UI loop and vsync on the UI thread, the Chip8 frame rate on the emulation thread. Either way
+ * each frame emulates the wall clock time since the last one, so the speed doesn't depend on
+ * how often frames run.
+ */
+class EmulationThread
+{
+public:
+    using Command = std::function<void(Chip8&)>;
+
+    // A finished screen. No pixels means the screen was cleared.
+    struct Frame
+    {
+        std::vector<uint32_t> pixels;
+        uint16_t width = 0;
+        uint16_t height = 0;
+    };
+
+    // What the UI shows of the Chip8, copied out after every frame
+    struct Snapshot
+    {
+        bool hasGame = false;
+        // Parked on FX0A until a key is pressed
+        bool waitingForKey = false;
+
+        uint16_t opcode = 0;
+        uint16_t indexReg = 0;
+        uint16_t pc = 0;
+        uint16_t sp = 0;
+        uint8_t delayTimer = 0;
+        uint8_t soundTimer = 0;
+        uint64_t vramGeneration = 0;
+        // Millions of instructions per second over the last measuring window
+        double mips = 0.0;
+        // Share of those instructions skipped in idle loops
+        double idleShare = 0.0;
+        // Frames that can be rewound and the bytes they take
+        size_t rewindStates = 0;
+        size_t rewindBytes = 0;
+        // Frames recorded or played of the movie, and the first played one that diverged
+        Movie::Mode movieMode = Movie::Mode::eIdle;
+        uint64_t movieFrame = 0;
+        uint64_t movieFrames = 0;
+        uint64_t movieDivergedFrame = Movie::NO_FRAME;
+
+        std::array<uint8_t, 16> v = {};
+        // Bit n set while key n is down
+        uint16_t keys = 0;
+
+        std::array<uint8_t, Chip8::MEM_SIZE> memory = {};
+        // Packed VRAM as bytes like Chip8::ReadVram, vramSize of them in the current mode
+        std::array<uint8_t, Chip8::VRAM_WORDS * sizeof(uint64_t)> vram = {};
+        uint32_t vramSize = 0;
+    };
+
+    // Settings the UI edits. The UI keeps its own copy so widgets don't wait a frame to see
+    // their changes.
+    struct Settings
+    {
+        uint32_t drawnColor = 0;
+        uint32_t undrawnColor = 0;
+        uint8_t emuSpeedModifier = 1;
+        uint32_t instructionsPerSecond = Chip8::DEFAULT_INSTRUCTIONS_PER_SECOND;
+        Chip8::Backend backend = Chip8::Backend::eTable;
+        bool jitLockstep = false;
+        bool coalesceFrames = true;
+        bool idleSkipping = true;
+        uint32_t inputSamplesPerTick = 1;
+        uint32_t runAheadFrames = 0;
+        // 0 turns rewind off
+        uint32_t rewindBudgetMiB = RewindBuffer::DEFAULT_BUDGET / (1024 * 1024);
+        Chip8::SaveSync saveSync = Chip8::SaveSync::eAsync;
+        bool useVYForShiftQuirk = false;
+        bool useBXNNQuirk = false;
+        bool useIndexIncrementAfterStoreLoadQuirk = false;
+        bool turbo = false;
+    };
+
+public:
+    EmulationThread(Chip8& chip8);
+    ~EmulationThread();
+
+    EmulationThread(const EmulationThread&) = delete;
+    EmulationThread& operator=(const EmulationThread&) = delete;
+
+    bool IsThreaded() const { return mThread.joinable(); }
+    void SetThreaded(const bool threaded);
+
+    // Runs a frame when not threaded and picks up the newest frame and snapshot. Returns whether
+    // there is a new frame to draw.
+    bool Update();
+    const Frame& GetFrame() const { return mFrames.GetReadBuffer(); }
+    const Snapshot& GetSnapshot() const { return mSnapshots.GetReadBuffer(); }
+    // Only updated while profiling is on
+    const Chip8::Profile& GetProfile() const { return mProfiles.GetReadBuffer(); }
+
+    // Runs the command on the Chip8 before its next frame
+    void Post(Command command);
+    // Changed keys also wake the emulation thread when the game is parked on FX0A, so the key
+    // press is seen right away instead of at the next frame
+    void PushKeys(const uint16_t keys);
+
+    // While rewinding, each frame steps back one recorded frame instead of emulating, so
+    // history plays backwards at the speed it was recorded
+    void SetRewinding(const bool rewinding);
+
+    // Both restart the game. A recording takes the keys and settings until StopMovie() and is
+    // saved then as <rom name>.c8movie in the directory, playback runs the movie's frames and
+    // hands back to the keyboard at its end. Rewinding also stops either, since a movie can't
+    // follow the game back in time.
+    void StartRecording(const std::filesystem::path& directory);
+    void StartPlayback(const std::filesystem::path& filepath);
+    void StopMovie();
+
+    const Settings& GetSettings() const { return mSettings; }
+    void SetSettings(const Settings& settings);
+
+    // Opcode log lines are only formatted while logging is on. Lines that don't fit in the queue
+    // before the UI gets to them are dropped.
+    void SetLogOpcodes(const bool logOpcodes);
+    bool PopLogLine(std::string& line) { return mLogLines.Pop(line); }
+
+    // Like the opcode log, profiling slows the Chip8 down, so it's only on while it's shown
+    void SetProfiling(const bool profiling);
+
+    // Publishes a cleared screen. Only for commands, which run on the emulation side.
+    void ClearFrame();
+
+private:
+    void ThreadMain();
+    void RunFrame();
+    // Runs the whole movie frames the time adds up to, so a movie doesn't depend on how the
+    // frames are paced
+    void RunMovieFrames(const float seconds);
+    void FinishMovie();
+    // Returns whether a key change ended the wait before the time
+    bool WaitUntil(const std::chrono::steady_clock::time_point time);
+
+    void UpdateInput(uint16_t& keys);
+    void PublishFrame(const std::vector<uint32_t>& pixels);
+    void PublishSnapshot();
+    void PublishProfile();
+    void MeasureMips();
+    void AddLogLine(const std::string& line);
+
+    static Settings ReadSettings(const Chip8& chip8);
+    static void ApplySettings(Chip8& chip8, const Settings& settings);
+
+private:
+    Chip8& mChip8;
+
+    std::thread mThread;
+    std::atomic<bool> mRunning = false;
+
+    std::mutex mWakeMutex;
+    std::condition_variable mWakeCondition;
+    bool mKeysChanged = false;
+    std::atomic<bool> mRewinding = false;
+
+    // UI to emulation
+    SpscQueue<Command, 64> mCommands;
+    SpscQueue<uint16_t, 64> mKeys;
+    uint16_t mPushedKeys = 0;
+    Settings mSettings;
+
+    // Emulation to UI
+    TripleBuffer<Frame> mFrames;
+    TripleBuffer<Snapshot> mSnapshots;
+    TripleBuffer<Chip8::Profile> mProfiles;
+    SpscQueue<std::string, 4096> mLogLines;
+
+    // The last keys taken off the queue, the settings last applied, the rewind history, the
+    // movie, when the last frame ran and the MIPS measurement, owned by the emulation side
+    uint16_t mLatestKeys = 0;
+    Settings mAppliedSettings;
+    RewindBuffer mRewind;
+    Movie mMovie;
+    std::filesystem::path mMovieFile;
+    // Time since the last movie frame that didn't add up to a frame
+    float mMovieTime = 0.0f;
+    std::chrono::steady_clock::time_point mLastFrameTime;
+    std::chrono::steady_clock::time_point mMipsWindowStart;
+    uint64_t mMipsWindowCycles = 0;
+    uint64_t mMipsWindowIdleCycles = 0;
+    double mMips = 0.0;
+    double mIdleShare = 0.0;
+};
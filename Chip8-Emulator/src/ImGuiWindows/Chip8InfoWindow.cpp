@@ -1,68 +1,140 @@
 #include "Chip8InfoWindow.h"
 
 #include "Log.h"
-#include "Chip8.h"
+#include "EmulationThread.h"
 
 #include <imgui.h>
 
+#include <algorithm>
+
 Chip8InfoWindow::Chip8InfoWindow(bool isOpen) :
     ImGuiWindow("Chip8 Info", "chip8InfoWindowOpen", isOpen)
 {}
 
 void Chip8InfoWindow::OnRender()
 {
-    if (!mChip8)
+    if (!mEmulation)
     {
-        ImGui::Text("Chip8 pointer is NULL!");
+        ImGui::Text("Emulation pointer is NULL!");
         return;
     }
 
-    ImVec4 drawnColor = ImGui::ColorConvertU32ToFloat4(mChip8->GetDrawnColor());
-    ImGui::ColorEdit3("Drawn", &drawnColor.x);
-    mChip8->SetDrawnColor(ImGui::ColorConvertFloat4ToU32(drawnColor));
+    // Settings are edited on the UI copy and only sent over when a widget changed them
+    EmulationThread::Settings settings = mEmulation->GetSettings();
+    bool changed = false;
+
+    ImVec4 drawnColor = ImGui::ColorConvertU32ToFloat4(settings.drawnColor);
+    if (ImGui::ColorEdit3("Drawn", &drawnColor.x))
+    {
+        settings.drawnColor = ImGui::ColorConvertFloat4ToU32(drawnColor);
+        changed = true;
+    }
+
+    ImVec4 undrawnColor = ImGui::ColorConvertU32ToFloat4(settings.undrawnColor);
+    if (ImGui::ColorEdit3("Undrawn", &undrawnColor.x))
+    {
+        settings.undrawnColor = ImGui::ColorConvertFloat4ToU32(undrawnColor);
+        changed = true;
+    }
 
-    ImVec4 undrawnColor = ImGui::ColorConvertU32ToFloat4(mChip8->GetUndrawnColor());
-    ImGui::ColorEdit3("Undrawn", &undrawnColor.x);
-    mChip8->SetUndrawnColor(ImGui::ColorConvertFloat4ToU32(undrawnColor));
+    int ips = (int)settings.instructionsPerSecond;
+    if (ImGui::InputInt("Instructions Per Second", &ips, 60, 600))
+    {
+        settings.instructionsPerSecond = (uint32_t)std::max(ips, 1);
+        changed = true;
+    }
+
+    int emuSpeed = (int)settings.emuSpeedModifier;
+    if (ImGui::SliderInt("Emu Speed Modifier", &emuSpeed, 1, 10))
+    {
+        settings.emuSpeedModifier = (uint8_t)emuSpeed;
+        changed = true;
+    }
+
+    static const char* const backendNames[] = { "Switch", "Table", "Block Cache", "JIT", "AOT" };
+    int backend = (int)settings.backend;
+    if (ImGui::Combo("Backend", &backend, backendNames, (int)std::size(backendNames)))
+    {
+        settings.backend = (Chip8::Backend)backend;
+        changed = true;
+    }
 
-    int emuSpeed = (int)mChip8->GetEmuSpeedModifier();
-    ImGui::SliderInt("Emu Speed Modifier", &emuSpeed, 1, 10);
-    mChip8->SetEmuSpeedModifier((uint8_t)emuSpeed);
+    changed |= ImGui::Checkbox("Turbo (Tab)", &settings.turbo);
+    changed |= ImGui::Checkbox("JIT Lockstep Check", &settings.jitLockstep);
+    changed |= ImGui::Checkbox("Present Once Per Frame", &settings.coalesceFrames);
+    changed |= ImGui::Checkbox("Skip Idle Loops", &settings.idleSkipping);
+
+    int inputSamples = (int)settings.inputSamplesPerTick;
+    if (ImGui::SliderInt("Input Samples Per Tick", &inputSamples, 1, 8))
+    {
+        settings.inputSamplesPerTick = (uint32_t)inputSamples;
+        changed = true;
+    }
+
+    int runAheadFrames = (int)settings.runAheadFrames;
+    if (ImGui::SliderInt("Run Ahead Frames", &runAheadFrames, 0, (int)Chip8::MAX_RUN_AHEAD_FRAMES))
+    {
+        settings.runAheadFrames = (uint32_t)runAheadFrames;
+        changed = true;
+    }
+
+    int rewindBudget = (int)settings.rewindBudgetMiB;
+    if (ImGui::InputInt("Rewind Budget MiB (Backspace)", &rewindBudget, 16, 64))
+    {
+        settings.rewindBudgetMiB = (uint32_t)std::clamp(rewindBudget, 0, 4096);
+        changed = true;
+    }
+
+    static const char* const saveSyncNames[] = { "OS Write Back", "Start Write Back", "Wait For Disk" };
+    int saveSync = (int)settings.saveSync;
+    if (ImGui::Combo("Save State Sync", &saveSync, saveSyncNames, (int)std::size(saveSyncNames)))
+    {
+        settings.saveSync = (Chip8::SaveSync)saveSync;
+        changed = true;
+    }
+
+    bool threaded = mEmulation->IsThreaded();
+    if (ImGui::Checkbox("Run On Emulation Thread", &threaded))
+        mEmulation->SetThreaded(threaded);
 
     ImGui::Separator();
 
     ImGui::Text("Quirk Flags");
 
-    bool useVYShiftQuirk = mChip8->GetUseVYForShiftQuirk();
-    ImGui::Checkbox("Use VY For Shift", &useVYShiftQuirk);
-    mChip8->SetUseVYForShiftQuirk(useVYShiftQuirk);
-
-    bool useBXNN = mChip8->GetUseBXNNQuirk();
-    ImGui::Checkbox("Use BXNN", &useBXNN);
-    mChip8->SetUseBXNNQuirk(useBXNN);
+    changed |= ImGui::Checkbox("Use VY For Shift", &settings.useVYForShiftQuirk);
+    changed |= ImGui::Checkbox("Use BXNN", &settings.useBXNNQuirk);
+    changed |= ImGui::Checkbox("Use Index Increment After Store and Load Memory", &settings.useIndexIncrementAfterStoreLoadQuirk);
 
-    bool useIndexIncrement = mChip8->GetUseIndexIncrementAfterStoreLoadQuirk();
-    ImGui::Checkbox("Use Index Increment After Store and Load Memory", &useIndexIncrement);
-    mChip8->SetUseIndexIncrementAfterStoreLoadQuirk(useIndexIncrement);
+    if (changed)
+        mEmulation->SetSettings(settings);
 
     ImGui::Separator();
 
-    ImGui::Text("Opcode: %X", mChip8->GetOpcode());
-    ImGui::Text("Index Reg: %X", mChip8->GetIndexReg());
-    ImGui::Text("Program Counter: %X", mChip8->GetProgramCounter());
-    ImGui::Text("Stack Pointer: %d", mChip8->GetStackPointer());
-    ImGui::Text("Delay Timer: %d", mChip8->GetDelayTimer());
-    ImGui::Text("Sound Timer: %d", mChip8->GetSoundTimer());
+    const EmulationThread::Snapshot& snapshot = mEmulation->GetSnapshot();
+    ImGui::Text("MIPS: %.2f", snapshot.mips);
+    ImGui::Text("Idle: %.0f%%", snapshot.idleShare * 100.0);
+    ImGui::Text("Rewind: %zu frames in %.1f MiB", snapshot.rewindStates, snapshot.rewindBytes / (1024.0 * 1024.0));
+    if (snapshot.movieMode == Movie::Mode::eRecording)
+        ImGui::Text("Movie: recording frame %llu", (unsigned long long)snapshot.movieFrame);
+    else if (snapshot.movieMode == Movie::Mode::ePlaying)
+        ImGui::Text("Movie: playing frame %llu of %llu", (unsigned long long)snapshot.movieFrame, (unsigned long long)snapshot.movieFrames);
+    if (snapshot.movieMode == Movie::Mode::ePlaying && snapshot.movieDivergedFrame != Movie::NO_FRAME)
+        ImGui::Text("Movie: diverged at frame %llu", (unsigned long long)snapshot.movieDivergedFrame);
+    ImGui::Text("Opcode: %X", snapshot.opcode);
+    ImGui::Text("Index Reg: %X", snapshot.indexReg);
+    ImGui::Text("Program Counter: %X", snapshot.pc);
+    ImGui::Text("Stack Pointer: %d", snapshot.sp);
+    ImGui::Text("Delay Timer: %d", snapshot.delayTimer);
+    ImGui::Text("Sound Timer: %d", snapshot.soundTimer);
+    ImGui::Text("VRAM Generation: %llu", (unsigned long long)snapshot.vramGeneration);
 
     ImGui::Separator();
 
-    const auto vreg = mChip8->GetVReg();
-    for (size_t i = 0; i < std::size(vreg); ++i)
-        ImGui::Text("V%X: %d", i, vreg[i]);
+    for (size_t i = 0; i < std::size(snapshot.v); ++i)
+        ImGui::Text("V%X: %d", i, snapshot.v[i]);
 
     ImGui::Separator();
 
-    const auto& keys = mChip8->GetKeys();
-    for (size_t i = 0; i < std::size(keys); ++i)
-        ImGui::Text("Key[%X] = %d", i, keys[i]);
+    for (uint32_t i = 0; i < 16; ++i)
+        ImGui::Text("Key[%X] = %d", i, (snapshot.keys >> i) & 1);
 }
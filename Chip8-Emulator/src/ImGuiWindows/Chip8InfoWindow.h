@@ -2,18 +2,18 @@
 
 #include "ImGuiWindow.h"
 
-class Chip8;
+class EmulationThread;
 
 class Chip8InfoWindow : public ImGuiWindow
 {
 public:
     Chip8InfoWindow(bool isOpen = false);
 
-    void SetChip8(Chip8* const chip8) { mChip8 = chip8; }
+    void SetEmulation(EmulationThread* const emulation) { mEmulation = emulation; }
 
 protected:
     void OnRender() override;
 
 private:
-    Chip8* mChip8 = nullptr;
+    EmulationThread* mEmulation = nullptr;
 };
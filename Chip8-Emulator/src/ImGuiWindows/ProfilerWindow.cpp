@@ -0,0 +1,211 @@
+#include "ProfilerWindow.h"
+
+#include "Chip8.h"
+#include "EmulationThread.h"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include <numeric>
+
+namespace
+{
+    constexpr size_t NumHotAddresses = 32;
+    constexpr size_t NumLoops = 8;
+    // Longest backwards jump that still counts as a tight loop
+    constexpr uint16_t MaxLoopBytes = 16;
+
+    uint16_t ReadOpcode(const EmulationThread::Snapshot& snapshot, const uint16_t pc)
+    {
+        return (snapshot.memory[pc] << 8) | snapshot.memory[(pc + 1) % Chip8::MEM_SIZE];
+    }
+
+    float Share(const uint64_t count, const uint64_t total)
+    {
+        return (total > 0) ? (float)count / total : 0.0f;
+    }
+}
+
+ProfilerWindow::ProfilerWindow(bool isOpen) :
+    ImGuiWindow("Profiler", "profilerWindowOpen", isOpen)
+{}
+
+void ProfilerWindow::OnRender()
+{
+    if (!mEmulation)
+    {
+        ImGui::Text("Emulation pointer is NULL!");
+        return;
+    }
+
+    const Chip8::Profile& profile = mEmulation->GetProfile();
+    ImGui::Text("Instructions: %llu", (unsigned long long)profile.totalCycles);
+    ImGui::SameLine();
+    if (ImGui::Button("Reset"))
+    {
+        mEmulation->Post([](Chip8& chip8) {
+            chip8.ResetProfile();
+        });
+    }
+
+    // Profiling starts when the window opens, so there's nothing to show until the first frame
+    if (std::empty(profile.pcCounts))
+        return;
+
+    if (ImGui::CollapsingHeader("Hottest Addresses", ImGuiTreeNodeFlags_DefaultOpen))
+        RenderHotAddresses();
+    if (ImGui::CollapsingHeader("Tight Loops", ImGuiTreeNodeFlags_DefaultOpen))
+        RenderLoops();
+    if (ImGui::CollapsingHeader("Opcode Classes"))
+        RenderOpcodeClasses();
+    if (ImGui::CollapsingHeader("DXYN Per Frame"))
+        RenderDraws();
+}
+
+void ProfilerWindow::RenderHotAddresses()
+{
+    const Chip8::Profile& profile = mEmulation->GetProfile();
+    const EmulationThread::Snapshot& snapshot = mEmulation->GetSnapshot();
+
+    mHotAddresses.clear();
+    for (uint32_t pc = 0; pc < std::size(profile.pcCounts); ++pc)
+    {
+        if (profile.pcCounts[pc] > 0)
+            mHotAddresses.push_back((uint16_t)pc);
+    }
+
+    const size_t numShown = std::min(NumHotAddresses, std::size(mHotAddresses));
+    std::partial_sort(std::begin(mHotAddresses), std::begin(mHotAddresses) + numShown, std::end(mHotAddresses),
+        [&](const uint16_t a, const uint16_t b) { return profile.pcCounts[a] > profile.pcCounts[b]; });
+
+    if (ImGui::BeginTable("HotAddresses", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit))
+    {
+        ImGui::TableSetupColumn("Address");
+        ImGui::TableSetupColumn("Count");
+        ImGui::TableSetupColumn("Share");
+        ImGui::TableSetupColumn("Instruction", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableHeadersRow();
+
+        for (size_t i = 0; i < numShown; ++i)
+        {
+            const uint16_t pc = mHotAddresses[i];
+            const uint64_t count = profile.pcCounts[pc];
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("0x%03X", pc);
+            ImGui::TableNextColumn();
+            ImGui::Text("%llu", (unsigned long long)count);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f%%", 100.0f * Share(count, profile.totalCycles));
+            ImGui::TableNextColumn();
+            if (pc + 1u < Chip8::MEM_SIZE)
+                ImGui::Text("%s", Chip8::DisassembleOpcode(std::data(snapshot.memory), pc).c_str());
+        }
+
+        ImGui::EndTable();
+    }
+}
+
+void ProfilerWindow::RenderLoops()
+{
+    const Chip8::Profile& profile = mEmulation->GetProfile();
+    const EmulationThread::Snapshot& snapshot = mEmulation->GetSnapshot();
+
+    FindLoops();
+    if (std::empty(mLoops))
+    {
+        ImGui::Text("No tight loops found");
+        return;
+    }
+
+    if (ImGui::BeginTable("Loops", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit))
+    {
+        ImGui::TableSetupColumn("Range");
+        ImGui::TableSetupColumn("Share");
+        ImGui::TableSetupColumn("Ends With", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableHeadersRow();
+
+        for (size_t i = 0; i < std::min(NumLoops, std::size(mLoops)); ++i)
+        {
+            const Loop& loop = mLoops[i];
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("0x%03X-0x%03X", loop.start, loop.end);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f%%", 100.0f * Share(loop.count, profile.totalCycles));
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", Chip8::DisassembleOpcode(std::data(snapshot.memory), loop.end).c_str());
+        }
+
+        ImGui::EndTable();
+    }
+}
+
+void ProfilerWindow::RenderOpcodeClasses()
+{
+    const Chip8::Profile& profile = mEmulation->GetProfile();
+
+    static const char* const classNames[] = {
+        "0NNN", "1NNN", "2NNN", "3XNN", "4XNN", "5XY0", "6XNN", "7XNN",
+        "8XYN", "9XY0", "ANNN", "BNNN", "CXNN", "DXYN", "EXNN", "FXNN"
+    };
+
+    for (size_t i = 0; i < std::size(profile.classCounts); ++i)
+    {
+        const float share = Share(profile.classCounts[i], profile.totalCycles);
+        char overlay[32] = {};
+        snprintf(overlay, sizeof(overlay), "%.2f%%", 100.0f * share);
+
+        ImGui::ProgressBar(share, ImVec2(200.0f, 0.0f), overlay);
+        ImGui::SameLine();
+        ImGui::Text("%s", classNames[i]);
+    }
+}
+
+void ProfilerWindow::RenderDraws()
+{
+    const Chip8::Profile& profile = mEmulation->GetProfile();
+
+    const uint64_t totalDraws = std::accumulate(std::begin(profile.drawsPerFrame), std::end(profile.drawsPerFrame), 0ull);
+    ImGui::Text("Average over the last %u frames: %.2f", Chip8::PROFILE_FRAMES, (double)totalDraws / Chip8::PROFILE_FRAMES);
+
+    // Oldest frame on the left
+    ImGui::PlotHistogram("##Draws", [](void* data, int i) {
+            return (float)((const Chip8::Profile*)data)->drawsPerFrame[i];
+        }, (void*)&profile, (int)Chip8::PROFILE_FRAMES, (int)profile.frameIndex, nullptr, 0.0f, FLT_MAX, ImVec2(0.0f, 80.0f));
+}
+
+void ProfilerWindow::FindLoops()
+{
+    const Chip8::Profile& profile = mEmulation->GetProfile();
+    const EmulationThread::Snapshot& snapshot = mEmulation->GetSnapshot();
+
+    mLoops.clear();
+    for (uint32_t pc = 0; pc < std::size(profile.pcCounts); ++pc)
+    {
+        if (profile.pcCounts[pc] == 0)
+            continue;
+
+        const uint16_t opcode = ReadOpcode(snapshot, (uint16_t)pc);
+        uint16_t start = 0;
+        if ((opcode & 0xF000) == 0x1000 && (opcode & 0x0FFF) <= pc && pc - (opcode & 0x0FFF) <= MaxLoopBytes)
+            start = opcode & 0x0FFF;
+        else if ((opcode & 0xF0FF) == 0xF00A)
+            start = (uint16_t)pc;
+        else
+            continue;
+
+        Loop loop;
+        loop.start = start;
+        loop.end = (uint16_t)pc;
+        for (uint32_t i = start; i <= pc; ++i)
+            loop.count += profile.pcCounts[i];
+        mLoops.push_back(loop);
+    }
+
+    std::sort(std::begin(mLoops), std::end(mLoops), [](const Loop& a, const Loop& b) { return a.count > b.count; });
+}
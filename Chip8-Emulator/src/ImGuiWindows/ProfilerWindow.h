@@ -0,0 +1,44 @@
+#pragma once
+
+#include "ImGuiWindow.h"
+
+#include <cstdint>
+#include <vector>
+
+class EmulationThread;
+
+// Shows where the running game spends its instructions. The Chip8 only profiles while this
+// window is open.
+class ProfilerWindow : public ImGuiWindow
+{
+public:
+    ProfilerWindow(bool isOpen = false);
+
+    void SetEmulation(EmulationThread* const emulation) { mEmulation = emulation; }
+
+protected:
+    void OnRender() override;
+
+private:
+    struct Loop
+    {
+        uint16_t start = 0;
+        uint16_t end = 0;
+        uint64_t count = 0;
+    };
+
+    void RenderHotAddresses();
+    void RenderLoops();
+    void RenderOpcodeClasses();
+    void RenderDraws();
+
+    // A jump back a few instructions or an FX0A waiting on a key
+    void FindLoops();
+
+private:
+    EmulationThread* mEmulation = nullptr;
+
+    // Scratch space kept between frames
+    std::vector<uint16_t> mHotAddresses;
+    std::vector<Loop> mLoops;
+};
@@ -9,6 +9,9 @@ OpenGLTexture::~OpenGLTexture()
 
 void OpenGLTexture::Create(uint32_t width, uint32_t height)
 {
+    mWidth = width;
+    mHeight = height;
+
     glActiveTexture(GL_TEXTURE0);
     glGenTextures(1, &mId);
     glBindTexture(GL_TEXTURE_2D, mId);
@@ -25,6 +28,8 @@ void OpenGLTexture::Destroy()
     {
         glDeleteTextures(1, &mId);
         mId = 0;
+        mWidth = 0;
+        mHeight = 0;
     }
 }
 
@@ -16,6 +16,11 @@ public:
 
     void Update(uint32_t width, uint32_t height, const char* const pixels);
 
+    uint32_t GetWidth() const { return mWidth; }
+    uint32_t GetHeight() const { return mHeight; }
+
 private:
     uint32_t mId = 0;
+    uint32_t mWidth = 0;
+    uint32_t mHeight = 0;
 };
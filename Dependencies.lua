@@ -1,5 +1,6 @@
 
 IncludeDir = {}
+IncludeDir["Chip8Core"] = "%{wks.location}/Chip8-Core/src"
 IncludeDir["Spdlog"] = "%{wks.location}/Chip8-Emulator/vendor/Spdlog/src"
 IncludeDir["glfw"] = "%{wks.location}/Chip8-Emulator/vendor/glfw/src"
 IncludeDir["glad"] = "%{wks.location}/Chip8-Emulator/vendor/glad/src"
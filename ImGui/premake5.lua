@@ -4,6 +4,7 @@ project "ImGui"
 	language "C++"
 	cppdialect "C++17"
     staticruntime "off"
+    removeplatforms { "Linux64" }
 
 	targetdir (outputTargetDir)
     objdir (outputObjDir)
@@ -7,15 +7,24 @@ outputObjDir = "Build/%{cfg.buildcfg}-%{cfg.platform}/Obj"
 workspace "Chip8-Emulator"
     startproject "Chip8-Emulator"
     configurations { "Debug", "Release", "Dist" }
-    platforms { "Win64" }
+    platforms { "Win64", "Linux64" }
     flags { "MultiProcessorCompile" }
 
     filter { "platforms:Win64" }
         system "windows"
         architecture "x86_64"
 
+    -- Only the headless projects build on Linux
+    filter { "platforms:Linux64" }
+        system "linux"
+        architecture "x86_64"
+
     filter { "system:windows" }
         systemversion "latest"
 
+include "Chip8-Core"
 include "Chip8-Emulator"
+include "Chip8-Cli"
+include "Chip8-Bench"
+include "Chip8-Aot"
 include "ImGui"